@@ -0,0 +1,83 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from dropping a value that is only computed for timing.
+template<typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+const size_t kBenchRepetitions = 5;
+
+struct CBenchResult {
+    std::string name;
+    size_t param;
+    double nsPerOp;
+};
+
+// Results of every benchmark that ran, printed as JSON by main().
+inline std::vector<CBenchResult>& BenchResults() {
+    static std::vector<CBenchResult> results;
+    return results;
+}
+
+// Only benchmarks whose name contains this string run, empty runs everything.
+inline std::string& BenchFilter() {
+    static std::string filter;
+    return filter;
+}
+
+inline bool BenchSelected(const std::string& name) {
+    return name.find(BenchFilter()) != std::string::npos;
+}
+
+// Runs func kBenchRepetitions times and returns the best time per operation in nanoseconds.
+template<typename Func>
+double MeasureNsPerOp(size_t operations, Func&& func) {
+    double best = 0;
+    for (size_t i = 0; i < kBenchRepetitions; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        func();
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - begin).count() / operations;
+        if (i == 0 || ns < best)
+            best = ns;
+    }
+
+    return best;
+}
+
+// Progress goes to stderr, so stdout stays valid JSON.
+inline void Report(const std::string& name, size_t param, double nsPerOp) {
+    BenchResults().push_back({name, param, nsPerOp});
+    std::cerr << name << '/' << param << '\t' << nsPerOp << " ns/op\n";
+}
+
+// Measures and reports func unless the filter skips name.
+template<typename Func>
+void RunBench(const std::string& name, size_t param, size_t operations, Func&& func) {
+    if (!BenchSelected(name))
+        return;
+    Report(name, param, MeasureNsPerOp(operations, func));
+}
+
+void PrintBenchJson(std::ostream& out);
+
+void BenchCapacityPolicy();
+
+void BenchConcurrent();
+
+void BenchShift();
+
+void BenchContainers();
+
+void BenchSimd();
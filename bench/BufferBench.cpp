@@ -0,0 +1,28 @@
+#include "Bench.h"
+
+#include <iomanip>
+
+// Benchmark names only use [A-Za-z0-9_/], so they are written without escaping.
+void PrintBenchJson(std::ostream& out) {
+    out << "{\n  \"repetitions\": " << kBenchRepetitions << ",\n  \"benchmarks\": [";
+    const std::vector<CBenchResult>& results = BenchResults();
+    for (size_t i = 0; i < results.size(); ++i) {
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"name\": \"" << results[i].name << "\", \"param\": " << results[i].param
+            << ", \"ns_per_op\": " << std::setprecision(6) << results[i].nsPerOp << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// Usage: BufferBench [filter]. Runs the benchmarks whose name contains filter
+// and prints the results as JSON to stdout, progress goes to stderr.
+int main(int argc, char** argv) {
+    if (argc > 1)
+        BenchFilter() = argv[1];
+    BenchContainers();
+    BenchCapacityPolicy();
+    BenchConcurrent();
+    BenchShift();
+    BenchSimd();
+    PrintBenchJson(std::cout);
+}
@@ -0,0 +1,61 @@
+#include "Bench.h"
+#include "lib/CCircularBuffer/CCircularBuffer.h"
+
+#include <cstdint>
+
+namespace {
+
+const size_t kOperations = 1 << 24;
+
+template<typename Policy>
+void BenchPushBack(const std::string& name, size_t capacity) {
+    CCircularBuffer<uint64_t, std::allocator<uint64_t>, Policy> buf(capacity);
+    RunBench(name, capacity, kOperations, [&buf] {
+        for (uint64_t i = 0; i < kOperations; ++i)
+            buf.push_back(i);
+        DoNotOptimize(buf.front());
+    });
+}
+
+template<typename Policy>
+void BenchPushPop(const std::string& name, size_t capacity) {
+    CCircularBuffer<uint64_t, std::allocator<uint64_t>, Policy> buf(capacity);
+    for (size_t i = 0; i < capacity / 2; ++i)
+        buf.push_back(i);
+    RunBench(name, capacity, kOperations, [&buf] {
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < kOperations; ++i) {
+            buf.push_back(i);
+            sum += buf.front();
+            buf.pop_front();
+        }
+        DoNotOptimize(sum);
+    });
+}
+
+template<typename Policy>
+void BenchIteratorAdvance(const std::string& name, size_t capacity) {
+    CCircularBuffer<uint64_t, std::allocator<uint64_t>, Policy> buf(capacity, 1);
+    RunBench(name, capacity, kOperations, [&buf] {
+        uint64_t sum = 0;
+        auto it = buf.begin();
+        for (size_t i = 0; i < kOperations; ++i) {
+            it += 7;
+            sum += *it;
+        }
+        DoNotOptimize(sum);
+    });
+}
+
+}
+
+void BenchCapacityPolicy() {
+    for (size_t capacity : {1000, 4096, 1000000, 1 << 20}) {
+        BenchPushBack<CModuloCapacity>("push_back/modulo", capacity);
+        BenchPushBack<CPowerOfTwoCapacity>("push_back/pow2", capacity);
+        BenchPushPop<CModuloCapacity>("push_pop/modulo", capacity);
+        BenchPushPop<CPowerOfTwoCapacity>("push_pop/pow2", capacity);
+        BenchIteratorAdvance<CModuloCapacity>("iterator_advance/modulo", capacity);
+        BenchIteratorAdvance<CPowerOfTwoCapacity>("iterator_advance/pow2", capacity);
+    }
+}
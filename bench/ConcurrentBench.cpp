@@ -0,0 +1,225 @@
+#include "Bench.h"
+#include "lib/CCircularBuffer/CCircularBuffer.h"
+#include "lib/CCircularBuffer/CSpscCircularBuffer.h"
+#include "lib/CCircularBuffer/CMpmcCircularBuffer.h"
+#include "lib/CCircularBuffer/CBlockingCircularBuffer.h"
+#include "lib/CCircularBuffer/CSharedSpscCircularBuffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint64_t kMessages = 1 << 22;
+
+// The layout CSpscCircularBuffer had before: both indices on one cache line and no cached copies,
+// so every push and pop reads the line the other thread is writing.
+template<typename T>
+class CPackedSpsc {
+public:
+    explicit CPackedSpsc(size_t capacity)
+        : data_(CPowerOfTwoCapacity::round_up(capacity)), readptr_(0), writeptr_(0) {}
+
+    bool try_push(const T& value) {
+        size_t write = writeptr_.load(std::memory_order_relaxed);
+        if (write - readptr_.load(std::memory_order_acquire) == data_.size())
+            return false;
+        data_[CPowerOfTwoCapacity::index(write, data_.size())] = value;
+        writeptr_.store(write + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool try_pop(T& value) {
+        size_t read = readptr_.load(std::memory_order_relaxed);
+        if (read == writeptr_.load(std::memory_order_acquire))
+            return false;
+        value = data_[CPowerOfTwoCapacity::index(read, data_.size())];
+        readptr_.store(read + 1, std::memory_order_release);
+
+        return true;
+    }
+private:
+    std::vector<T> data_;
+    std::atomic<size_t> readptr_;
+    std::atomic<size_t> writeptr_;
+};
+
+// Run with a filter, e.g. `perf stat -e cache-misses BufferBench spsc/packed`,
+// to compare the coherence traffic of the two layouts.
+template<typename Buffer>
+void BenchSpsc(const std::string& name, size_t capacity) {
+    Buffer buf(capacity);
+    RunBench(name, capacity, kMessages, [&buf] {
+        std::thread producer([&buf] {
+            for (uint64_t i = 0; i < kMessages; ++i)
+                while (!buf.try_push(i))
+                    std::this_thread::yield();
+        });
+        uint64_t sum = 0;
+        uint64_t value;
+        for (uint64_t i = 0; i < kMessages; ++i) {
+            while (!buf.try_pop(value))
+                std::this_thread::yield();
+            sum += value;
+        }
+        producer.join();
+        DoNotOptimize(sum);
+    });
+}
+
+#ifdef __linux__
+// Same loop as BenchSpsc, but each thread works through its own mapping of a shared-memory segment.
+void BenchSharedSpsc(size_t capacity) {
+    CSharedSpscCircularBuffer<uint64_t> consumer("/BufferBench_spsc_" + std::to_string(getpid()), capacity);
+    CSharedSpscCircularBuffer<uint64_t> producer(consumer.name());
+    RunBench("spsc/shared_memory", capacity, kMessages, [&consumer, &producer] {
+        std::thread thread([&producer] {
+            for (uint64_t i = 0; i < kMessages; ++i)
+                while (!producer.try_push(i))
+                    std::this_thread::yield();
+        });
+        uint64_t sum = 0;
+        uint64_t value;
+        for (uint64_t i = 0; i < kMessages; ++i) {
+            while (!consumer.try_pop(value))
+                std::this_thread::yield();
+            sum += value;
+        }
+        thread.join();
+        DoNotOptimize(sum);
+    });
+}
+#endif
+
+void BenchMutex(size_t capacity) {
+    CCircularBuffer<uint64_t> buf(capacity);
+    std::mutex mutex;
+    RunBench("spsc/mutex", capacity, kMessages, [&buf, &mutex] {
+        std::thread producer([&buf, &mutex] {
+            for (uint64_t i = 0; i < kMessages;) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!buf.full()) {
+                    buf.push_back(i);
+                    ++i;
+                }
+            }
+        });
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < kMessages;) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!buf.empty()) {
+                sum += buf.front();
+                buf.pop_front();
+                ++i;
+            }
+        }
+        producer.join();
+        DoNotOptimize(sum);
+    });
+}
+
+// Blocking push and pop, the baseline is a mutex with two condition variables.
+template<typename Buffer>
+void BenchBlocking(const std::string& name, size_t capacity) {
+    Buffer buf(capacity);
+    RunBench(name, capacity, kMessages, [&buf] {
+        std::thread producer([&buf] {
+            for (uint64_t i = 0; i < kMessages; ++i)
+                buf.push(i);
+        });
+        uint64_t sum = 0;
+        uint64_t value;
+        for (uint64_t i = 0; i < kMessages; ++i) {
+            buf.pop(value);
+            sum += value;
+        }
+        producer.join();
+        DoNotOptimize(sum);
+    });
+}
+
+template<typename T>
+class CCondVarRing {
+public:
+    explicit CCondVarRing(size_t capacity) : buf_(capacity) {}
+
+    void push(const T& value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [this] { return !buf_.full(); });
+        buf_.push_back(value);
+        lock.unlock();
+        notEmpty_.notify_one();
+    }
+
+    void pop(T& value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [this] { return !buf_.empty(); });
+        value = buf_.front();
+        buf_.pop_front();
+        lock.unlock();
+        notFull_.notify_one();
+    }
+private:
+    CCircularBuffer<T> buf_;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+};
+
+// threads producers and threads consumers share one queue, bulk sets the batch size.
+void BenchMpmc(size_t threads, size_t bulk) {
+    CMpmcCircularBuffer<uint64_t> buf(4096);
+    RunBench(bulk == 1 ? "mpmc/single" : "mpmc/bulk16", threads, kMessages, [&buf, threads, bulk] {
+        std::atomic<uint64_t> consumed(0);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&buf, threads, bulk] {
+                std::vector<uint64_t> batch(bulk, 1);
+                for (uint64_t i = 0; i < kMessages / threads;) {
+                    size_t done = buf.try_enqueue_bulk(batch.begin(), std::min<uint64_t>(bulk, kMessages / threads - i));
+                    if (done == 0)
+                        std::this_thread::yield();
+                    i += done;
+                }
+            });
+            workers.emplace_back([&buf, &consumed, threads, bulk] {
+                std::vector<uint64_t> batch(bulk);
+                while (consumed.load(std::memory_order_relaxed) < kMessages / threads * threads) {
+                    size_t done = buf.try_dequeue_bulk(batch.begin(), bulk);
+                    if (done == 0)
+                        std::this_thread::yield();
+                    consumed.fetch_add(done, std::memory_order_relaxed);
+                }
+            });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+    });
+}
+
+}
+
+void BenchConcurrent() {
+    for (size_t capacity : {1024, 65536}) {
+        BenchSpsc<CSpscCircularBuffer<uint64_t>>("spsc/lock_free", capacity);
+        BenchSpsc<CPackedSpsc<uint64_t>>("spsc/packed", capacity);
+#ifdef __linux__
+        BenchSharedSpsc(capacity);
+#endif
+        BenchMutex(capacity);
+        BenchBlocking<CBlockingCircularBuffer<uint64_t, CBusySpinWait>>("blocking/busy_spin", capacity);
+        BenchBlocking<CBlockingCircularBuffer<uint64_t, CSpinYieldWait<>>>("blocking/spin_yield", capacity);
+        BenchBlocking<CBlockingCircularBuffer<uint64_t, CSpinParkWait<>>>("blocking/spin_park", capacity);
+        BenchBlocking<CCondVarRing<uint64_t>>("blocking/condition_variable", capacity);
+    }
+    size_t maxThreads = std::max<size_t>(1, std::thread::hardware_concurrency() / 2);
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        BenchMpmc(threads, 1);
+        BenchMpmc(threads, 16);
+    }
+}
@@ -0,0 +1,405 @@
+#include "Bench.h"
+#include "lib/CCircularBuffer/CCircularBuffer.h"
+#include "lib/CCircularBuffer/CCircularBufferExt.h"
+#include "lib/CCircularBuffer/CHugePageAllocator.h"
+#include "lib/CCircularBuffer/CPersistentCircularBuffer.h"
+#include "lib/CCircularBuffer/CSlidingWindow.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace {
+
+const size_t kOperations = 1 << 20;
+
+// Element of Size bytes, value() is what the benchmarks sum up.
+template<size_t Size>
+struct CBlob {
+    uint64_t data[Size / sizeof(uint64_t)];
+
+    CBlob() = default;
+    CBlob(uint64_t value) : data() { data[0] = value; }
+
+    uint64_t value() const { return data[0]; }
+};
+
+// The ring most code would write by hand: a std::vector of fixed size with a head index.
+template<typename T>
+class CVectorRing {
+public:
+    using value_type = T;
+
+    explicit CVectorRing(size_t capacity) : data_(capacity), head_(0), size_(0) {}
+
+    void push_back(const T& value) {
+        if (size_ == data_.size()) {
+            data_[head_] = value;
+            head_ = next(head_);
+        } else {
+            data_[slot(size_)] = value;
+            ++size_;
+        }
+    }
+
+    void pop_front() {
+        head_ = next(head_);
+        --size_;
+    }
+
+    T& front() { return data_[head_]; }
+
+    T& operator[](size_t i) { return data_[slot(i)]; }
+
+    // Shifts the tail one element at a time.
+    void insert(size_t offset, const T& value) {
+        if (size_ < data_.size())
+            ++size_;
+        for (size_t i = size_ - 1; i > offset; --i)
+            data_[slot(i)] = std::move(data_[slot(i - 1)]);
+        data_[slot(offset)] = value;
+    }
+
+    void erase(size_t offset) {
+        for (size_t i = offset; i + 1 < size_; ++i)
+            data_[slot(i)] = std::move(data_[slot(i + 1)]);
+        --size_;
+    }
+
+    // Reallocates and unwraps, keeping the first elements that fit.
+    void resize(size_t capacity) {
+        std::vector<T> data(capacity);
+        size_t n = std::min(size_, capacity);
+        for (size_t i = 0; i < n; ++i)
+            data[i] = std::move(data_[slot(i)]);
+        data_.swap(data);
+        head_ = 0;
+        size_ = n;
+    }
+
+    template<typename Func>
+    void for_each(Func&& func) {
+        size_t head = std::min(size_, data_.size() - head_);
+        for (size_t i = head_; i < head_ + head; ++i)
+            func(data_[i]);
+        for (size_t i = 0; i < size_ - head; ++i)
+            func(data_[i]);
+    }
+
+    size_t size() const { return size_; }
+private:
+    std::vector<T> data_;
+    size_t head_;
+    size_t size_;
+
+    size_t slot(size_t i) const { return (head_ + i) % data_.size(); }
+
+    size_t next(size_t pos) const { return pos + 1 == data_.size() ? 0 : pos + 1; }
+};
+
+// The three containers are driven through these overloads, so every benchmark is written once.
+template<typename T, typename A, typename C, typename S>
+CCircularBuffer<T, A, C, S> MakeBuffer(CCircularBuffer<T, A, C, S>*, size_t capacity) {
+    return CCircularBuffer<T, A, C, S>(capacity);
+}
+
+template<typename T>
+std::deque<T> MakeBuffer(std::deque<T>*, size_t) { return std::deque<T>(); }
+
+template<typename T>
+std::vector<T> MakeBuffer(std::vector<T>*, size_t) { return std::vector<T>(); }
+
+template<typename T>
+CVectorRing<T> MakeBuffer(CVectorRing<T>*, size_t capacity) { return CVectorRing<T>(capacity); }
+
+template<typename T, typename A, typename C, typename S>
+void PushOverwrite(CCircularBuffer<T, A, C, S>& buf, size_t, const T& value) { buf.push_back(value); }
+
+template<typename T>
+void PushOverwrite(std::deque<T>& buf, size_t capacity, const T& value) {
+    if (buf.size() == capacity)
+        buf.pop_front();
+    buf.push_back(value);
+}
+
+template<typename T>
+void PushOverwrite(CVectorRing<T>& buf, size_t, const T& value) { buf.push_back(value); }
+
+template<typename T>
+void PushOverwrite(std::vector<T>& buf, size_t, const T& value) { buf.push_back(value); }
+
+template<typename Container, typename Func>
+void ForEach(Container& buf, Func&& func) {
+    for (auto& value : buf)
+        func(value);
+}
+
+template<typename T, typename Func>
+void ForEach(CVectorRing<T>& buf, Func&& func) { buf.for_each(func); }
+
+template<typename T>
+void InsertAt(CCircularBuffer<T>& buf, size_t offset, const T& value) { buf.insert(buf.cbegin() + offset, value); }
+
+template<typename T>
+void InsertAt(std::deque<T>& buf, size_t offset, const T& value) { buf.insert(buf.cbegin() + offset, value); }
+
+template<typename T>
+void InsertAt(CVectorRing<T>& buf, size_t offset, const T& value) { buf.insert(offset, value); }
+
+template<typename T>
+void EraseAt(CCircularBuffer<T>& buf, size_t offset) { buf.erase(buf.cbegin() + offset); }
+
+template<typename T>
+void EraseAt(std::deque<T>& buf, size_t offset) { buf.erase(buf.cbegin() + offset); }
+
+template<typename T>
+void EraseAt(CVectorRing<T>& buf, size_t offset) { buf.erase(offset); }
+
+template<typename Container>
+Container MakeFilled(size_t capacity, size_t size) {
+    Container buf = MakeBuffer(static_cast<Container*>(nullptr), capacity);
+    for (size_t i = 0; i < size; ++i)
+        PushOverwrite(buf, capacity, typename Container::value_type(i));
+
+    return buf;
+}
+
+template<typename Container>
+void BenchPushPop(const std::string& name, size_t capacity) {
+    using T = typename Container::value_type;
+    Container half = MakeFilled<Container>(capacity, capacity / 2);
+    RunBench(name + "/push_pop", capacity, kOperations, [&half, capacity] {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < kOperations; ++i) {
+            PushOverwrite(half, capacity, T(i));
+            sum += half.front().value();
+            half.pop_front();
+        }
+        DoNotOptimize(sum);
+    });
+    Container full = MakeFilled<Container>(capacity, capacity);
+    RunBench(name + "/push_overwrite", capacity, kOperations, [&full, capacity] {
+        for (size_t i = 0; i < kOperations; ++i)
+            PushOverwrite(full, capacity, T(i));
+        DoNotOptimize(full.front());
+    });
+}
+
+template<typename Container>
+void BenchAccess(const std::string& name, size_t capacity) {
+    Container buf = MakeFilled<Container>(capacity, capacity + capacity / 3);
+    size_t passes = std::max<size_t>(1, kOperations / capacity);
+    RunBench(name + "/iterate", capacity, passes * capacity, [&buf, passes] {
+        uint64_t sum = 0;
+        for (size_t pass = 0; pass < passes; ++pass)
+            ForEach(buf, [&sum](const auto& value) { sum += value.value(); });
+        DoNotOptimize(sum);
+    });
+    RunBench(name + "/index", capacity, passes * capacity, [&buf, passes, capacity] {
+        uint64_t sum = 0;
+        for (size_t pass = 0; pass < passes; ++pass)
+            for (size_t i = 0, j = 0; i < capacity; ++i, j = (j + 7 < capacity ? j + 7 : j + 7 - capacity))
+                sum += buf[j].value();
+        DoNotOptimize(sum);
+    });
+}
+
+// Refills the buffer from a vector and drains it, either element by element or in spans with consume_all().
+template<typename T>
+void BenchDrain(const std::string& name, size_t capacity) {
+    CCircularBuffer<T> buf(capacity);
+    std::vector<T> source(capacity, T(1));
+    buf.push_back(source.begin(), source.begin() + capacity / 3);
+    buf.pop_front(capacity / 3);
+    size_t passes = std::max<size_t>(1, kOperations / capacity);
+    RunBench(name + "/drain_front_pop", capacity, passes * capacity, [&buf, &source, passes] {
+        uint64_t sum = 0;
+        for (size_t pass = 0; pass < passes; ++pass) {
+            buf.push_back(source.begin(), source.end());
+            while (!buf.empty()) {
+                sum += buf.front().value();
+                buf.pop_front();
+            }
+        }
+        DoNotOptimize(sum);
+    });
+    RunBench(name + "/drain_consume", capacity, passes * capacity, [&buf, &source, passes] {
+        uint64_t sum = 0;
+        for (size_t pass = 0; pass < passes; ++pass) {
+            buf.push_back(source.begin(), source.end());
+            buf.consume_all([&sum](const T* first, size_t n) {
+                for (size_t i = 0; i < n; ++i)
+                    sum += first[i].value();
+            });
+        }
+        DoNotOptimize(sum);
+    });
+}
+
+#ifdef __linux__
+// push_overwrite on a file-backed journal, to compare with the in-memory circular_buffer case.
+template<typename T>
+void BenchJournal(const std::string& name, size_t capacity, EDurability durability) {
+    std::string path = "/tmp/BufferBench_journal_" + std::to_string(getpid());
+    unlink(path.c_str());
+    CJournalOptions options;
+    options.durability = durability;
+    {
+        CPersistentCircularBuffer<T> buf(path, capacity, options);
+        for (size_t i = 0; i < capacity; ++i)
+            buf.push_back(T(i));
+        RunBench(name + "/push_overwrite", capacity, kOperations, [&buf] {
+            for (size_t i = 0; i < kOperations; ++i)
+                buf.push_back(T(i));
+            DoNotOptimize(buf.front());
+        });
+    }
+    unlink(path.c_str());
+}
+#endif
+
+// Erases one element from the middle and inserts it back, so the size stays at capacity - 1.
+template<typename Container>
+void BenchInsertErase(const std::string& name, size_t capacity) {
+    using T = typename Container::value_type;
+    Container buf = MakeFilled<Container>(capacity, capacity - 1);
+    size_t operations = std::max<size_t>(16, (kOperations >> 4) / capacity);
+    RunBench(name + "/insert_erase_middle", capacity, operations, [&buf, operations, capacity] {
+        for (size_t i = 0; i < operations; ++i) {
+            EraseAt(buf, capacity / 2);
+            InsertAt(buf, capacity / 2, T(i));
+        }
+        DoNotOptimize(buf.front());
+    });
+}
+
+// Doubles a full, wrapped buffer and shrinks it back, one operation is one resize.
+template<typename Container>
+void BenchResize(const std::string& name, size_t capacity) {
+    Container buf = MakeFilled<Container>(capacity, capacity + capacity / 3);
+    size_t operations = std::max<size_t>(2, (kOperations >> 2) / capacity * 2);
+    RunBench(name + "/resize", capacity, operations, [&buf, operations, capacity] {
+        for (size_t i = 0; i < operations; i += 2) {
+            buf.resize(2 * capacity);
+            buf.resize(capacity);
+        }
+        DoNotOptimize(buf.front());
+    });
+}
+
+// Grows from an empty container to size elements by push_back.
+template<typename Container>
+void BenchGrowth(const std::string& name, size_t size) {
+    using T = typename Container::value_type;
+    RunBench(name + "/growth", size, size, [size] {
+        Container buf;
+        for (size_t i = 0; i < size; ++i)
+            buf.push_back(T(i));
+        DoNotOptimize(buf.back());
+    });
+}
+
+// std::sort and std::lower_bound through the iterators of a wrapped ring, against a std::vector.
+template<typename Container>
+void BenchAlgorithms(const std::string& name, size_t capacity) {
+    Container buf = MakeFilled<Container>(capacity, capacity);
+    std::vector<uint32_t> values(capacity);
+    for (size_t i = 0; i < capacity; ++i)
+        values[i] = static_cast<uint32_t>(i * 2654435761u);
+    RunBench(name + "/sort", capacity, capacity, [&buf, &values] {
+        std::copy(values.begin(), values.end(), buf.begin());
+        std::sort(buf.begin(), buf.end());
+        DoNotOptimize(buf.front());
+    });
+    size_t lookups = std::max<size_t>(kOperations >> 2, capacity);
+    RunBench(name + "/lower_bound", capacity, lookups, [&buf, &values, lookups] {
+        size_t found = 0;
+        for (size_t i = 0; i < lookups; ++i)
+            found += std::lower_bound(buf.begin(), buf.end(), values[i % values.size()]) - buf.begin();
+        DoNotOptimize(found);
+    });
+}
+
+// One tick pushes a sample and reads sum, variance, min and max of the window,
+// either from CSlidingWindow or by scanning the whole CCircularBuffer.
+void BenchWindow(size_t capacity) {
+    size_t ticks = std::max<size_t>(64, (kOperations >> 6) / capacity * 64);
+    CSlidingWindow<double> window(capacity);
+    CCircularBuffer<double> buf(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        window.push_back(double(i % 1000));
+        buf.push_back(double(i % 1000));
+    }
+    RunBench("window/sliding_window", capacity, ticks, [&window, ticks] {
+        double result = 0;
+        for (size_t i = 0; i < ticks; ++i) {
+            window.push_back(double(i % 1000));
+            result += window.sum() + window.variance() + window.min() + window.max();
+        }
+        DoNotOptimize(result);
+    });
+    RunBench("window/scan", capacity, ticks, [&buf, ticks] {
+        double result = 0;
+        for (size_t i = 0; i < ticks; ++i) {
+            buf.push_back(double(i % 1000));
+            double sum = 0;
+            double min = buf.front();
+            double max = buf.front();
+            for (double value : buf) {
+                sum += value;
+                min = std::min(min, value);
+                max = std::max(max, value);
+            }
+            double mean = sum / buf.size();
+            double squares = 0;
+            for (double value : buf)
+                squares += (value - mean) * (value - mean);
+            result += sum + squares / buf.size() + min + max;
+        }
+        DoNotOptimize(result);
+    });
+}
+
+template<typename T>
+void BenchElement(const std::string& element) {
+    for (size_t capacity : {1 << 10, 1 << 16, 1 << 20}) {
+        BenchPushPop<CCircularBuffer<T>>("circular_buffer/" + element, capacity);
+        BenchPushPop<std::deque<T>>("deque/" + element, capacity);
+        BenchPushPop<CVectorRing<T>>("vector_ring/" + element, capacity);
+        BenchPushPop<CCircularBuffer<T, std::allocator<T>, CModuloCapacity, CCountingStats>>(
+            "circular_buffer_stats/" + element, capacity);
+        BenchAccess<CCircularBuffer<T>>("circular_buffer/" + element, capacity);
+        BenchAccess<std::deque<T>>("deque/" + element, capacity);
+        BenchAccess<CVectorRing<T>>("vector_ring/" + element, capacity);
+        BenchDrain<T>("circular_buffer/" + element, capacity);
+#ifdef __linux__
+        BenchPushPop<CCircularBuffer<T, CHugePageAllocator<T>>>("circular_buffer_huge_page/" + element, capacity);
+        BenchAccess<CCircularBuffer<T, CHugePageAllocator<T>>>("circular_buffer_huge_page/" + element, capacity);
+        BenchJournal<T>("journal_none/" + element, capacity, EDurability::kNone);
+        BenchJournal<T>("journal_periodic/" + element, capacity, EDurability::kPeriodic);
+#endif
+        BenchResize<CCircularBuffer<T>>("circular_buffer/" + element, capacity);
+        BenchResize<CVectorRing<T>>("vector_ring/" + element, capacity);
+        BenchGrowth<CCircularBufferExt<T>>("circular_buffer_ext/" + element, capacity);
+        BenchGrowth<std::deque<T>>("deque/" + element, capacity);
+        BenchGrowth<std::vector<T>>("vector/" + element, capacity);
+        BenchInsertErase<CCircularBuffer<T>>("circular_buffer/" + element, capacity);
+        BenchInsertErase<std::deque<T>>("deque/" + element, capacity);
+        BenchInsertErase<CVectorRing<T>>("vector_ring/" + element, capacity);
+    }
+}
+
+}
+
+void BenchContainers() {
+    for (size_t capacity : {1 << 10, 100000})
+        BenchWindow(capacity);
+    for (size_t capacity : {1 << 10, 1 << 20}) {
+        BenchAlgorithms<CCircularBuffer<uint32_t>>("algorithms/circular_buffer", capacity);
+        BenchAlgorithms<std::vector<uint32_t>>("algorithms/vector", capacity);
+    }
+    BenchElement<CBlob<8>>("8B");
+    BenchElement<CBlob<64>>("64B");
+    BenchElement<CBlob<256>>("256B");
+}
@@ -0,0 +1,49 @@
+#include "Bench.h"
+#include "lib/CCircularBuffer/CCircularBuffer.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+const size_t kShiftOperations = 1000;
+
+// Erases one element and inserts it back at the same offset, so the size stays constant.
+void BenchShortestSide(const std::string& name, size_t size, size_t offset) {
+    CCircularBuffer<uint64_t> buf(size + 1, 1);
+    buf.pop_back();
+    RunBench(name, size, kShiftOperations, [&buf, offset] {
+        for (size_t i = 0; i < kShiftOperations; ++i) {
+            buf.erase(buf.cbegin() + offset);
+            buf.insert(buf.cbegin() + offset, i);
+        }
+        DoNotOptimize(buf.front());
+    });
+}
+
+// The previous algorithm: always moves the tail one element at a time through the wrapping iterator.
+void BenchTailShift(const std::string& name, size_t size, size_t offset) {
+    CCircularBuffer<uint64_t> buf(size + 1, 1);
+    buf.pop_back();
+    RunBench(name, size, kShiftOperations, [&buf, offset] {
+        for (size_t i = 0; i < kShiftOperations; ++i) {
+            std::move(buf.begin() + (offset + 1), buf.end(), buf.begin() + offset);
+            buf.pop_back();
+            buf.push_back(0);
+            std::move_backward(buf.begin() + offset, buf.end() - 1, buf.end());
+            buf[offset] = i;
+        }
+        DoNotOptimize(buf.front());
+    });
+}
+
+}
+
+void BenchShift() {
+    for (size_t size : {1 << 10, 1 << 16, 1 << 20}) {
+        BenchTailShift("erase_insert/front/tail_shift", size, size / 16);
+        BenchShortestSide("erase_insert/front/shortest_side", size, size / 16);
+        BenchTailShift("erase_insert/middle/tail_shift", size, size / 2);
+        BenchShortestSide("erase_insert/middle/shortest_side", size, size / 2);
+    }
+}
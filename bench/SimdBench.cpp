@@ -0,0 +1,69 @@
+#include "Bench.h"
+#include "lib/CCircularBuffer/CAlignedAllocator.h"
+#include "lib/CCircularBuffer/CCircularBuffer.h"
+#include "lib/CCircularBuffer/CSimdKernels.h"
+
+#include <cstdint>
+
+namespace {
+
+const char* LevelName(ESimdLevel level) {
+    switch (level) {
+        case ESimdLevel::kSse2:
+            return "sse2";
+        case ESimdLevel::kAvx2:
+            return "avx2";
+        case ESimdLevel::kAvx512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+// A risk check over a wrapped ring: sum, max and the number of values over a limit, one operation is one element.
+template<typename T, typename Allocator>
+void BenchScan(const std::string& name, size_t capacity) {
+    CCircularBuffer<T, Allocator> buf(capacity);
+    for (size_t i = 0; i < capacity + capacity / 3; ++i)
+        buf.push_back(T(i % 1000));
+    size_t passes = std::max<size_t>(1, (1 << 24) / capacity);
+    RunBench(name + "/iterator", capacity, passes * capacity, [&buf, passes] {
+        T result = 0;
+        for (size_t pass = 0; pass < passes; ++pass) {
+            T sum = 0;
+            T max = buf.front();
+            size_t over = 0;
+            for (T value : buf) {
+                sum += value;
+                max = std::max(max, value);
+                over += value > T(900);
+            }
+            result += sum + max + T(over);
+        }
+        DoNotOptimize(result);
+    });
+    ESimdLevel detected = DetectSimdLevel();
+    for (ESimdLevel level : {ESimdLevel::kScalar, ESimdLevel::kSse2, ESimdLevel::kAvx2, ESimdLevel::kAvx512}) {
+        if (level > detected)
+            break;
+        SetSimdLevel(level);
+        RunBench(name + "/" + LevelName(level), capacity, passes * capacity, [&buf, passes] {
+            T result = 0;
+            for (size_t pass = 0; pass < passes; ++pass)
+                result += SimdSum(buf) + SimdMax(buf) + T(SimdCount(buf, ECompare::kGreater, T(900)));
+            DoNotOptimize(result);
+        });
+    }
+    SetSimdLevel(detected);
+}
+
+}
+
+void BenchSimd() {
+    for (size_t capacity : {1 << 10, 1 << 20}) {
+        BenchScan<int32_t, std::allocator<int32_t>>("simd/int32", capacity);
+        BenchScan<int32_t, CAlignedAllocator<int32_t>>("simd/int32_aligned", capacity);
+        BenchScan<double, std::allocator<double>>("simd/double", capacity);
+        BenchScan<double, CAlignedAllocator<double>>("simd/double_aligned", capacity);
+    }
+}
@@ -0,0 +1 @@
+#include "CAlignedAllocator.h"
@@ -0,0 +1,34 @@
+#pragma once
+#include "CCacheLine.h"
+
+#include <cstddef>
+#include <new>
+
+// Allocator whose blocks start on an Alignment boundary, so the second segment of a ring,
+// which always starts at the beginning of the storage, can be read with aligned vector loads.
+template<typename T, size_t Alignment = kCacheLineSize>
+class CAlignedAllocator {
+    static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two");
+public:
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = CAlignedAllocator<U, Alignment>;
+    };
+
+    CAlignedAllocator() = default;
+
+    template<typename U>
+    CAlignedAllocator(const CAlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment))); }
+
+    void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(Alignment)); }
+
+    template<typename U>
+    bool operator==(const CAlignedAllocator<U, Alignment>&) const { return true; }
+
+    template<typename U>
+    bool operator!=(const CAlignedAllocator<U, Alignment>&) const { return false; }
+};
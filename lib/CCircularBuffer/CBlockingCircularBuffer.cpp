@@ -0,0 +1 @@
+#include "CBlockingCircularBuffer.h"
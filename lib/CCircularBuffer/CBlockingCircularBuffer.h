@@ -0,0 +1,208 @@
+#pragma once
+#include "CCacheLine.h"
+#include "CMpmcCircularBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// Wait strategies decide what a blocked push or pop does on its iteration-th failed attempt:
+// idle() either burns a little time and returns false, or returns true to park the thread
+// until the other side signals progress.
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Never leaves the CPU, the lowest latency when every thread has a core of its own.
+struct CBusySpinWait {
+    static bool idle(size_t) {
+        CpuRelax();
+        return false;
+    }
+};
+
+// Spins for a short while, then gives the core away with yield() but stays runnable.
+template<size_t Spins = 128>
+struct CSpinYieldWait {
+    static bool idle(size_t iteration) {
+        if (iteration < Spins)
+            CpuRelax();
+        else
+            std::this_thread::yield();
+        return false;
+    }
+};
+
+// Spins, yields a few times and then parks on a futex, so an idle thread uses no CPU.
+template<size_t Spins = 128, size_t Yields = 16>
+struct CSpinParkWait {
+    static bool idle(size_t iteration) {
+        if (iteration < Spins)
+            CpuRelax();
+        else if (iteration < Spins + Yields)
+            std::this_thread::yield();
+        else
+            return true;
+        return false;
+    }
+};
+
+// Parking spot for the threads blocked on one side of the ring. The other side bumps epoch_
+// and issues a wake only when waiters_ says somebody is parked, so there is no syscall in steady state.
+class CParkingLot {
+public:
+    CParkingLot() : epoch_(0), waiters_(0) {}
+
+    uint32_t epoch() const { return epoch_.load(std::memory_order_acquire); }
+
+    // Registers the caller as parked. Check the condition again after this and before wait().
+    void enter() {
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void leave() { waiters_.fetch_sub(1, std::memory_order_relaxed); }
+
+    // Sleeps while epoch_ is still seen or until timeout, a negative timeout waits forever.
+    void wait(uint32_t seen, std::chrono::nanoseconds timeout) {
+#ifdef __linux__
+        timespec ts;
+        timespec* tsp = nullptr;
+        if (timeout.count() >= 0) {
+            ts.tv_sec = timeout.count() / 1000000000;
+            ts.tv_nsec = timeout.count() % 1000000000;
+            tsp = &ts;
+        }
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, seen, tsp, nullptr, 0);
+#else
+        if (epoch_.load(std::memory_order_acquire) == seen)
+            std::this_thread::yield();
+#endif
+    }
+
+    // Called after the other side made progress.
+    void notify_all() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) == 0)
+            return;
+        epoch_.fetch_add(1, std::memory_order_release);
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+    }
+private:
+    std::atomic<uint32_t> epoch_;
+    std::atomic<uint32_t> waiters_;
+};
+
+// Thread-safe bounded ring for any number of producers and consumers that can block when it is
+// full or empty. Built on CMpmcCircularBuffer, WaitStrategy picks how a blocked thread waits.
+template<typename T, typename WaitStrategy = CSpinParkWait<>, typename Allocator = std::allocator<T>>
+class CBlockingCircularBuffer {
+private:
+    CMpmcCircularBuffer<T, Allocator> queue_;
+    alignas(kCacheLineSize) CParkingLot notEmpty_;
+    alignas(kCacheLineSize) CParkingLot notFull_;
+
+    // Retries attempt() until it succeeds or timeout passes, a negative timeout never passes.
+    template<typename Attempt>
+    bool wait_for(CParkingLot& lot, std::chrono::nanoseconds timeout, Attempt&& attempt) {
+        using clock = std::chrono::steady_clock;
+        clock::time_point deadline = clock::now() + std::max(timeout, std::chrono::nanoseconds(0));
+        for (size_t iteration = 0;; ++iteration) {
+            if (attempt())
+                return true;
+            if (timeout.count() >= 0 && clock::now() >= deadline)
+                return false;
+            if (!WaitStrategy::idle(iteration))
+                continue;
+            uint32_t seen = lot.epoch();
+            lot.enter();
+            if (attempt()) {
+                lot.leave();
+                return true;
+            }
+            std::chrono::nanoseconds left = timeout;
+            if (timeout.count() >= 0)
+                left = std::max(std::chrono::nanoseconds(deadline - clock::now()), std::chrono::nanoseconds(0));
+            lot.wait(seen, left);
+            lot.leave();
+        }
+    }
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    explicit CBlockingCircularBuffer(size_t size, const Allocator& alloc = Allocator()) : queue_(size, alloc) {}
+
+    bool try_push(const value_type& value) { return this->try_emplace(value); }
+
+    bool try_push(value_type&& value) { return this->try_emplace(std::move(value)); }
+
+    template<typename... Args>
+    bool try_emplace(Args&&... args) {
+        if (!queue_.try_emplace(std::forward<Args>(args)...))
+            return false;
+        notEmpty_.notify_all();
+
+        return true;
+    }
+
+    bool try_pop(value_type& value) {
+        if (!queue_.try_dequeue(value))
+            return false;
+        notFull_.notify_all();
+
+        return true;
+    }
+
+    void push(const value_type& value) { this->push_for(value, std::chrono::nanoseconds(-1)); }
+
+    void push(value_type&& value) { this->push_for(std::move(value), std::chrono::nanoseconds(-1)); }
+
+    void pop(value_type& value) { this->pop_for(value, std::chrono::nanoseconds(-1)); }
+
+    // Waits up to timeout for free space, returns false if there was none.
+    template<typename Rep, typename Period>
+    bool push_for(const value_type& value, std::chrono::duration<Rep, Period> timeout) {
+        return this->wait_for(notFull_, std::chrono::duration_cast<std::chrono::nanoseconds>(timeout),
+                              [this, &value] { return this->try_push(value); });
+    }
+
+    // value is only moved from when the push succeeds.
+    template<typename Rep, typename Period>
+    bool push_for(value_type&& value, std::chrono::duration<Rep, Period> timeout) {
+        return this->wait_for(notFull_, std::chrono::duration_cast<std::chrono::nanoseconds>(timeout),
+                              [this, &value] { return this->try_push(std::move(value)); });
+    }
+
+    // Waits up to timeout for an element, returns false if none arrived.
+    template<typename Rep, typename Period>
+    bool pop_for(value_type& value, std::chrono::duration<Rep, Period> timeout) {
+        return this->wait_for(notEmpty_, std::chrono::duration_cast<std::chrono::nanoseconds>(timeout),
+                              [this, &value] { return this->try_pop(value); });
+    }
+
+    size_type size() const { return queue_.size(); }
+
+    size_type capacity() const { return queue_.capacity(); }
+
+    bool empty() const { return queue_.empty(); }
+};
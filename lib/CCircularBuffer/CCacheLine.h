@@ -0,0 +1,11 @@
+#pragma once
+#include <cstddef>
+
+// Size of a cache line on the targets we care about, std::hardware_destructive_interference_size
+// is not reliable across compilers.
+const size_t kCacheLineSize = 64;
+
+// Unit of storage for buffers that want their elements to start on a cache line.
+struct alignas(kCacheLineSize) CCacheLine {
+    unsigned char bytes[kCacheLineSize];
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+
+// Capacity policies decide how a buffer maps its read/write positions onto slots.
+// index() turns a stored position into a slot, next()/prev()/advance()/retreat() move a position,
+// wrap() reduces an arbitrary offset into [0, capacity).
+
+// Keeps positions inside [0, capacity) and wraps them with integer division.
+struct CModuloCapacity {
+    static size_t round_up(size_t capacity) { return capacity; }
+
+    static size_t wrap(size_t offset, size_t capacity) { return offset % capacity; }
+
+    static size_t index(size_t pos, size_t) { return pos; }
+
+    static size_t next(size_t pos, size_t capacity) { return (pos + 1) % capacity; }
+
+    static size_t prev(size_t pos, size_t capacity) { return pos == 0 ? capacity - 1 : pos - 1; }
+
+    static size_t advance(size_t pos, size_t n, size_t capacity) { return (pos + n) % capacity; }
+
+    static size_t retreat(size_t pos, size_t n, size_t capacity) { return (pos + capacity - n) % capacity; }
+};
+
+// Rounds capacity up to a power of two. Positions are free-running counters
+// and a slot is found by masking, so no division happens on the hot path.
+struct CPowerOfTwoCapacity {
+    static size_t round_up(size_t capacity) {
+        if (capacity <= 1)
+            return capacity;
+        size_t result = 1;
+        while (result < capacity)
+            result <<= 1;
+
+        return result;
+    }
+
+    static size_t wrap(size_t offset, size_t capacity) { return offset & (capacity - 1); }
+
+    static size_t index(size_t pos, size_t capacity) { return pos & (capacity - 1); }
+
+    static size_t next(size_t pos, size_t) { return pos + 1; }
+
+    static size_t prev(size_t pos, size_t) { return pos - 1; }
+
+    static size_t advance(size_t pos, size_t n, size_t) { return pos + n; }
+
+    static size_t retreat(size_t pos, size_t n, size_t) { return pos - n; }
+};
@@ -1,15 +1,317 @@
 #pragma once
-#include <iostream>
+#include "CCapacityPolicy.h"
+#include "CStatsPolicy.h"
 
-template<typename T, typename Allocator = std::allocator<T>>
-class CCircularBuffer{
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/uio.h>
+#endif
+
+// Allocators with decommit(pointer, bytes) can give pages of a live allocation back to the system,
+// see CLazyPageAllocator. The buffer then calls it for every page that no longer holds an element.
+template<typename Allocator, typename = void>
+struct CDecommitsPages : std::false_type {};
+
+template<typename Allocator>
+struct CDecommitsPages<Allocator, std::void_t<decltype(std::declval<Allocator&>().decommit(std::declval<void*>(), size_t()))>>
+    : std::true_type {};
+
+// StatsPolicy is a private base, so the empty CNoStats adds nothing to the size of the buffer.
+template<typename T, typename Allocator = std::allocator<T>, typename CapacityPolicy = CModuloCapacity,
+         typename StatsPolicy = CNoStats>
+class CCircularBuffer : private StatsPolicy {
 private:
     size_t capacity_;
     size_t size_;
     T* start_;
-    uint32_t readptr_;
-    uint32_t writeptr_;
+    size_t readptr_;
+    size_t writeptr_;
     Allocator alloc_;
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+    size_t index(size_t pos) const { return CapacityPolicy::index(pos, capacity_); }
+
+    T* allocate(size_t n) { return n == 0 ? nullptr : alloc_traits::allocate(alloc_, n); }
+
+    // Destroys the elements and gives the storage back to the allocator.
+    void release() {
+        this->clear();
+        if (start_ != nullptr)
+            alloc_traits::deallocate(alloc_, start_, capacity_);
+        start_ = nullptr;
+        capacity_ = 0;
+    }
+
+    // Takes over the storage of other, which must have been allocated by an allocator equal to alloc_.
+    void steal(CCircularBuffer& other) {
+        capacity_ = other.capacity_;
+        size_ = other.size_;
+        start_ = other.start_;
+        readptr_ = other.readptr_;
+        writeptr_ = other.writeptr_;
+        other.capacity_ = 0;
+        other.size_ = 0;
+        other.start_ = nullptr;
+        other.readptr_ = 0;
+        other.writeptr_ = 0;
+        StatsPolicy::record_size(size_);
+    }
+
+    // Copies or moves the elements of other into this empty buffer, allocating its capacity if needed.
+    template<typename Buffer>
+    void assign_from(Buffer&& other) {
+        if (capacity_ < other.capacity_) {
+            this->release();
+            start_ = this->allocate(other.capacity_);
+            capacity_ = other.capacity_;
+        }
+        auto one = other.array_one();
+        auto two = other.array_two();
+        if constexpr (std::is_rvalue_reference_v<Buffer&&>) {
+            this->push_back(std::make_move_iterator(one.first), std::make_move_iterator(one.first + one.second));
+            this->push_back(std::make_move_iterator(two.first), std::make_move_iterator(two.first + two.second));
+            other.clear();
+        } else {
+            this->push_back(one.first, one.first + one.second);
+            this->push_back(two.first, two.first + two.second);
+        }
+    }
+
+    // Slots from readptr_ up to writeptr_ hold constructed elements, all other slots are raw storage.
+    template<typename... Args>
+    void construct(size_t pos, Args&&... args) {
+        alloc_traits::construct(alloc_, start_ + index(pos), std::forward<Args>(args)...);
+    }
+
+    void destroy(size_t pos) { alloc_traits::destroy(alloc_, start_ + index(pos)); }
+
+    // Position and slot of the element at logical offset i from the front.
+    size_t position(size_t i) const { return CapacityPolicy::advance(readptr_, i, capacity_); }
+
+    T* slot(size_t i) const { return start_ + index(position(i)); }
+
+    size_t head() const { return index(readptr_); }
+
+    // Slot of the element at logical offset i with one add and one conditional subtract.
+    // Offsets past the storage keep wrapping around it, as they always did.
+    static size_t logical_slot(size_t head, size_t i, size_t capacity) {
+        size_t pos = head + i;
+        if (pos >= capacity) {
+            pos -= capacity;
+            if (pos >= capacity)
+                pos = CapacityPolicy::wrap(pos, capacity);
+        }
+
+        return pos;
+    }
+
+    size_t logical_slot(size_t i) const { return logical_slot(this->head(), i, capacity_); }
+
+    // Counts the wraps of a position moved n slots forward or backward from pos.
+    void count_advance(size_t pos, size_t n) {
+        if constexpr (StatsPolicy::kEnabled) {
+            if (n != 0 && capacity_ != 0)
+                StatsPolicy::add_wraps(n < capacity_ ? index(pos) + n >= capacity_ : (index(pos) + n) / capacity_);
+        }
+    }
+
+    void count_retreat(size_t pos, size_t n) {
+        if constexpr (StatsPolicy::kEnabled) {
+            if (n != 0 && capacity_ != 0)
+                StatsPolicy::add_wraps(n < capacity_ ? index(pos) < n : (capacity_ - 1 - index(pos) + n) / capacity_);
+        }
+    }
+
+    static void move_chunk(T* source, T* dest, size_t n, bool backward) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (n != 0)
+                std::memmove(dest, source, n * sizeof(T));
+        } else if (backward)
+            std::move_backward(source, source + n, dest + n);
+        else
+            std::move(source, source + n, dest);
+    }
+
+    // Moves n live elements from ring position from to ring position to in contiguous chunks.
+    // backward goes from the last element to the first and must be used when to is after from.
+    void move_slots(size_t from, size_t to, size_t n, bool backward) {
+        while (n != 0) {
+            size_t source;
+            size_t dest;
+            size_t chunk;
+            if (backward) {
+                size_t sourceEnd = index(CapacityPolicy::advance(from, n - 1, capacity_)) + 1;
+                size_t destEnd = index(CapacityPolicy::advance(to, n - 1, capacity_)) + 1;
+                chunk = std::min(n, std::min(sourceEnd, destEnd));
+                source = sourceEnd - chunk;
+                dest = destEnd - chunk;
+            } else {
+                source = index(from);
+                dest = index(to);
+                chunk = std::min(n, std::min(capacity_ - source, capacity_ - dest));
+                from = CapacityPolicy::advance(from, chunk, capacity_);
+                to = CapacityPolicy::advance(to, chunk, capacity_);
+            }
+            move_chunk(start_ + source, start_ + dest, chunk, backward);
+            n -= chunk;
+        }
+    }
+
+    // Makes room for grow elements before offset by moving the elements from offset to the end right.
+    void open_back(size_t offset, size_t grow) {
+        size_t tail = size_ - offset;
+        size_t raw = std::min(grow, tail);
+        if constexpr (!std::is_trivially_copyable_v<T>) {
+            for (size_t i = size_; i > size_ - raw; --i)
+                alloc_traits::construct(alloc_, slot(i - 1 + grow), std::move(*slot(i - 1)));
+        } else
+            raw = 0;
+        move_slots(position(offset), position(offset + grow), tail - raw, true);
+        count_advance(writeptr_, grow);
+        writeptr_ = CapacityPolicy::advance(writeptr_, grow, capacity_);
+        size_ += grow;
+        StatsPolicy::add_shifted(tail);
+        StatsPolicy::record_size(size_);
+    }
+
+    // Makes room for grow elements after the first keep elements by moving those keep elements left.
+    void open_front(size_t keep, size_t grow) {
+        size_t read = CapacityPolicy::retreat(readptr_, grow, capacity_);
+        size_t raw = std::min(grow, keep);
+        if constexpr (!std::is_trivially_copyable_v<T>) {
+            for (size_t i = 0; i < raw; ++i)
+                alloc_traits::construct(alloc_, start_ + index(CapacityPolicy::advance(read, i, capacity_)),
+                                        std::move(*slot(i)));
+        } else
+            raw = 0;
+        move_slots(position(raw), CapacityPolicy::advance(read, raw, capacity_), keep - raw, false);
+        count_retreat(readptr_, grow);
+        readptr_ = read;
+        size_ += grow;
+        StatsPolicy::add_shifted(keep);
+        StatsPolicy::record_size(size_);
+    }
+
+    // Constructs n elements in raw storage at dest, a single memcpy when the source is raw storage of a trivial type.
+    template<typename InputIterator>
+    InputIterator construct_slots(InputIterator first, size_t n, T* dest) {
+        if constexpr (std::is_trivially_copyable_v<T> && std::is_pointer_v<InputIterator> &&
+                      std::is_same_v<std::remove_cv_t<std::remove_pointer_t<InputIterator>>, T>) {
+            if (n != 0)
+                std::memcpy(dest, first, n * sizeof(T));
+            return first + n;
+        } else {
+            for (; n > 0; --n, ++first, ++dest)
+                alloc_traits::construct(alloc_, dest, *first);
+            return first;
+        }
+    }
+
+    // Moves n elements from source into raw storage at dest and ends their lifetime in source.
+    void relocate_slots(T* source, size_t n, T* dest) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (n != 0)
+                std::memcpy(dest, source, n * sizeof(T));
+        } else {
+            for (; n > 0; --n, ++source, ++dest) {
+                alloc_traits::construct(alloc_, dest, std::move(*source));
+                alloc_traits::destroy(alloc_, source);
+            }
+        }
+    }
+
+    // Whether [begin, end) bytes of the storage share memory with a live element.
+    bool overlaps_live(size_t begin, size_t end) const {
+        size_t first = index(readptr_) * sizeof(T);
+        size_t head = std::min(size_, capacity_ - index(readptr_)) * sizeof(T);
+        size_t tail = size_ * sizeof(T) - head;
+
+        return (begin < first + head && first < end) || begin < tail;
+    }
+
+    // Decommits the pages inside slots [from, to) that no live element touches.
+    void decommit_range(size_t from, size_t to) {
+        size_t page = alloc_.page_size();
+        size_t begin = from * sizeof(T) / page * page;
+        size_t end = (to * sizeof(T) + page - 1) / page * page;
+        if (overlaps_live(begin, begin + page))
+            begin += page;
+        if (end > begin && overlaps_live(end - page, end))
+            end -= page;
+        if (begin < end)
+            alloc_.decommit(reinterpret_cast<char*>(start_) + begin, end - begin);
+    }
+
+    // Called after n slots from position pos lost their elements.
+    void decommit_slots(size_t pos, size_t n) {
+        if constexpr (CDecommitsPages<Allocator>::value) {
+            if (n == 0)
+                return;
+            size_t first = index(pos);
+            size_t head = std::min(n, capacity_ - first);
+            decommit_range(first, first + head);
+            if (head != n)
+                decommit_range(0, n - head);
+        }
+    }
+
+    // Removes n elements from the front, destructors are skipped for trivially destructible types.
+    void destroy_front(size_t n) {
+        if (n == 0)
+            return;
+        size_t read = readptr_;
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            size_t pos = readptr_;
+            for (size_t i = 0; i < n; ++i, pos = CapacityPolicy::next(pos, capacity_))
+                destroy(pos);
+        }
+        count_advance(readptr_, n);
+        readptr_ = CapacityPolicy::advance(readptr_, n, capacity_);
+        size_ -= n;
+        decommit_slots(read, n);
+    }
+
+    // Removes n elements from the back, destructors are skipped for trivially destructible types.
+    void destroy_back(size_t n) {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t i = size_ - n; i < size_; ++i)
+                alloc_traits::destroy(alloc_, slot(i));
+        }
+        count_retreat(writeptr_, n);
+        size_ -= n;
+        writeptr_ = CapacityPolicy::advance(readptr_, size_, capacity_);
+        decommit_slots(writeptr_, n);
+    }
+
+    template<typename Func>
+    static size_t consume_span(T* first, size_t n, Func& fn) {
+        if (n == 0)
+            return 0;
+        if constexpr (std::is_void_v<std::invoke_result_t<Func&, T*, size_t>>) {
+            fn(first, n);
+            return n;
+        } else
+            return std::min<size_t>(fn(first, n), n);
+    }
+
+    template<typename OutputIterator>
+    static OutputIterator copy_from_slots(const T* source, size_t n, OutputIterator out) {
+        if constexpr (std::is_trivially_copyable_v<T> && std::is_same_v<OutputIterator, T*>) {
+            if (n != 0)
+                std::memcpy(out, source, n * sizeof(T));
+            return out + n;
+        } else
+            return std::copy_n(source, n, out);
+    }
 public:
     using value_type = T;
     using const_value_type = const T;
@@ -19,245 +321,202 @@ public:
     using const_pointer = const T*;
     using size_type = std::size_t;
     using difference_type = std::ptrdiff_t;
+    using allocator_type = Allocator;
+    // pointer to a contiguous part of the storage and the number of elements in it
+    using array_range = std::pair<pointer, size_type>;
+    using const_array_range = std::pair<const_pointer, size_type>;
 
     CCircularBuffer() : capacity_(0), start_(nullptr), readptr_(0), writeptr_(0), size_(0) {}
 
-    explicit CCircularBuffer(size_t size) : capacity_(size) {
-        start_ = alloc_.allocate(size);
+    explicit CCircularBuffer(const Allocator& alloc)
+        : capacity_(0), size_(0), start_(nullptr), readptr_(0), writeptr_(0), alloc_(alloc) {}
+
+    explicit CCircularBuffer(size_t size, const Allocator& alloc = Allocator())
+        : capacity_(CapacityPolicy::round_up(size)), alloc_(alloc) {
+        start_ = this->allocate(capacity_);
         readptr_ = 0;
         writeptr_ = 0;
         size_ = 0;
     }
 
-    CCircularBuffer(size_t size, T sample) : capacity_(size) {
-        start_ = alloc_.allocate(size);
+    CCircularBuffer(size_t size, T sample, const Allocator& alloc = Allocator())
+        : capacity_(CapacityPolicy::round_up(size)), alloc_(alloc) {
+        start_ = this->allocate(capacity_);
         readptr_ = 0;
         writeptr_ = 0;
-        size_ = size;
-        for (; writeptr_ != size; start_[writeptr_] = sample, writeptr_++);
-        writeptr_ = 0;
+        size_ = 0;
+        for (; size_ != size; ++size_, writeptr_ = CapacityPolicy::next(writeptr_, capacity_))
+            construct(writeptr_, sample);
+        StatsPolicy::record_size(size_);
+    }
+
+    CCircularBuffer(const CCircularBuffer& other)
+        : CCircularBuffer(other, alloc_traits::select_on_container_copy_construction(other.alloc_)) {}
+
+    CCircularBuffer(const CCircularBuffer& other, const Allocator& alloc)
+        : capacity_(other.capacity_), size_(other.size_), readptr_(0), alloc_(alloc) {
+        start_ = this->allocate(capacity_);
+        const_array_range one = other.array_one();
+        const_array_range two = other.array_two();
+        construct_slots(one.first, one.second, start_);
+        construct_slots(two.first, two.second, start_ + one.second);
+        writeptr_ = capacity_ == 0 ? 0 : CapacityPolicy::advance(0, size_, capacity_);
+        StatsPolicy::record_size(size_);
+    }
+
+    CCircularBuffer(CCircularBuffer&& other) noexcept
+        : capacity_(other.capacity_), size_(other.size_), start_(other.start_),
+          readptr_(other.readptr_), writeptr_(other.writeptr_), alloc_(std::move(other.alloc_)) {
+        other.capacity_ = 0;
+        other.size_ = 0;
+        other.start_ = nullptr;
+        other.readptr_ = 0;
+        other.writeptr_ = 0;
+        StatsPolicy::record_size(size_);
+    }
+
+    // Moves the elements one by one when alloc can not free the storage of other.
+    CCircularBuffer(CCircularBuffer&& other, const Allocator& alloc)
+        : capacity_(0), size_(0), start_(nullptr), readptr_(0), writeptr_(0), alloc_(alloc) {
+        if (alloc_ == other.alloc_)
+            this->steal(other);
+        else
+            this->assign_from(std::move(other));
     }
 
-    explicit CCircularBuffer(const CCircularBuffer<T>& other) {
-        readptr_ = other.readptr_;
-        writeptr_ = other.writeptr_;
-        size_ = other.size_;
-        capacity_ = other.capacity_;
-        start_ = alloc_.allocate(other.capacity_);
-        for (size_type i = 0; i < other.size_; ++i) {
-            start_[i] = other.start_[i];
+    ~CCircularBuffer() { this->release(); }
+
+    // The allocator follows other only when propagate_on_container_copy_assignment says so.
+    CCircularBuffer& operator=(const CCircularBuffer& other) {
+        if (this == &other)
+            return *this;
+        if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+            if (alloc_ != other.alloc_)
+                this->release();
+            alloc_ = other.alloc_;
         }
-    }
+        this->clear();
+        this->assign_from(other);
 
-    ~CCircularBuffer() {
-        alloc_.deallocate(start_, capacity_);
+        return *this;
     }
 
-
-    CCircularBuffer& operator=(const CCircularBuffer<value_type>& other) {
-        this->clear();
-        if (capacity_ < other.capacity_) {
-            alloc_.deallocate(start_, capacity_);
-            start_ = alloc_.allocate(other.capacity_);
-            capacity_ = other.capacity_;
-            size_ = other.size_;
-            for (size_type i = 0; i < other.size_; ++i)
-                start_[i] = other.start_[i];
-            readptr_ = other.readptr_;
-            writeptr_ = other.writeptr_;
+    // Takes the storage of other when the allocator propagates or both allocators are equal,
+    // otherwise moves the elements into storage from alloc_.
+    CCircularBuffer& operator=(CCircularBuffer&& other)
+        noexcept(alloc_traits::propagate_on_container_move_assignment::value || alloc_traits::is_always_equal::value) {
+        if (this == &other)
+            return *this;
+        if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+            this->release();
+            alloc_ = std::move(other.alloc_);
+            this->steal(other);
         } else {
-            for (size_type i = 0; i < other.size_; ++i)
-                this->push_back(other.start_[i]);
+            if (alloc_ == other.alloc_) {
+                this->release();
+                this->steal(other);
+            } else {
+                this->clear();
+                this->assign_from(std::move(other));
+            }
         }
 
         return *this;
     }
 
+    allocator_type get_allocator() const { return alloc_; }
+
+    // Random-access iterator made of the storage, the slot of front() and a logical offset from front(),
+    // so moving is plain offset arithmetic and a dereference is one add and one conditional subtract.
+    // A reverse iterator at offset o refers to the element at o - 1, as std::reverse_iterator does.
     template<typename Tp, bool ReverseIterator = false>
     class Iterator {
     public:
-        using value_type = Tp;
+        using value_type = std::remove_const_t<Tp>;
         using reference = Tp&;
         using pointer = Tp*;
         using difference_type = std::ptrdiff_t;
         using iterator_category = std::random_access_iterator_tag;
 
-        Iterator(pointer ptr, pointer start, size_type size, bool cycle) {
-            ptr_ = ptr;
-            start_ = start;
-            size_ = size;
-            cycle_ = cycle;
-        }
+        Iterator() : start_(nullptr), head_(0), capacity_(0), offset_(0) {}
+
+        Iterator(pointer start, size_type head, size_type capacity, difference_type offset)
+            : start_(start), head_(head), capacity_(capacity), offset_(offset) {}
 
-        ~Iterator() = default;
+        reference operator*() const { return *this->slot(0); }
 
-        reference operator*() { return *ptr_; }
+        pointer operator->() const { return this->slot(0); }
 
-        Iterator& operator=(const Iterator<Tp, ReverseIterator>& it) {
-            ptr_ = it.ptr_;
-            start_ = it.start_;
-            size_ = it.size_;
-            cycle_ = it.cycle_;
+        reference operator[](difference_type n) const { return *this->slot(ReverseIterator ? -n : n); }
+
+        Iterator& operator++() {
+            offset_ += kStep;
 
             return *this;
         }
 
         Iterator operator++(int) {
             Iterator temp = *this;
-            if (ReverseIterator) {
-                --(*this);
-            } else
-                ++(*this);
+            offset_ += kStep;
 
             return temp;
         }
 
-        Iterator& operator++() {
-            if (ReverseIterator) {
-                if (ptr_ == start_) {
-                    ptr_ = start_ + size_ - 1;
-                    cycle_ = !cycle_;
-                } else
-                    --(this->ptr_);
-            } else {
-                if (ptr_ - start_ == size_ - 1) {
-                    ptr_ = start_;
-                    cycle_ = !cycle_;
-                } else
-                    ++(this->ptr_);
-            }
+        Iterator& operator--() {
+            offset_ -= kStep;
 
             return *this;
         }
 
         Iterator operator--(int) {
             Iterator temp = *this;
-            if (ReverseIterator)
-                ++(*this);
-            else
-                --(*this);
+            offset_ -= kStep;
 
             return temp;
         }
 
-        Iterator& operator--() {
-            if (ReverseIterator) {
-                if (ptr_ - start_ == size_ - 1) {
-                    ptr_ = start_;
-                    cycle_ = !cycle_;
-                } else
-                    ++(this->ptr_);
-            } else {
-                if (ptr_ == start_) {
-                    ptr_ = start_ + size_ - 1;
-                    cycle_ = !cycle_;
-                } else
-                    --(this->ptr_);
-            }
+        Iterator& operator+=(difference_type n) {
+            offset_ += kStep * n;
 
             return *this;
         }
 
-        Iterator& operator+=(const difference_type n) {
-            if (ReverseIterator) {
-                *this -= -1 * (n);
-            } else {
-                bool sign = n < 0;
-                difference_type shift;
-                if (sign)
-                    shift = -1 * ((-1 * n) % size_);
-                else
-                    shift = n % size_;
-                if (!sign) {
-                    if (shift > start_ + size_ - 1 - ptr_)
-                        cycle_ = !cycle_;
-                    shift = (ptr_ - start_ + shift) % size_;
-                    ptr_ = start_ + shift;
-                } else {
-                    if (shift + ptr_ < start_)
-                        cycle_ = !cycle_;
-                    shift = (ptr_ - start_ + (size_ + shift)) % size_;
-                    ptr_ = start_ + shift;
-                }
-            }
+        Iterator& operator-=(difference_type n) {
+            offset_ -= kStep * n;
 
             return *this;
         }
 
-        Iterator operator+(const difference_type& n) {
-            Iterator temp = *this;
+        Iterator operator+(difference_type n) const { return Iterator(start_, head_, capacity_, offset_ + kStep * n); }
 
-            return temp += n;
-        }
+        friend Iterator operator+(difference_type n, const Iterator& it) { return it + n; }
 
-        friend Iterator operator+(const difference_type n, Iterator& it) {
-            Iterator temp = it;
-            if (ReverseIterator)
-                return temp -= n;
-            else
-                return temp += n;
-        }
+        Iterator operator-(difference_type n) const { return Iterator(start_, head_, capacity_, offset_ - kStep * n); }
 
-        Iterator operator-=(const difference_type n) {
-            if (ReverseIterator) {
-                bool sign = n < 0;
-                difference_type shift;
-                if (sign)
-                    shift = -1 * ((-1 * n) % size_);
-                else
-                    shift = n % size_;
-                if (!sign) {
-                    if (shift > start_ + size_ - 1 - ptr_)
-                        cycle_ = !cycle_;
-                    shift = (ptr_ - start_ + shift) % size_;
-                    ptr_ = start_ + shift;
-                } else {
-                    if (shift + ptr_ < start_)
-                        cycle_ = !cycle_;
-                    shift = (ptr_ - start_ + (size_ + shift)) % size_;
-                    ptr_ = start_ + shift;
-                }
-            } else {
-                *this += -1 * (n);
-            }
+        difference_type operator-(const Iterator& it) const { return kStep * (offset_ - it.offset_); }
 
-            return *this;
+        operator Iterator<const Tp, ReverseIterator>() const {
+            return Iterator<const Tp, ReverseIterator>(start_, head_, capacity_, offset_);
         }
 
-        Iterator operator-(const difference_type n) {
-            Iterator temp = *this;
-
-            return (temp -= n);
-        }
-
-        difference_type operator-(const Iterator& it) {
-            if (cycle_ == it.cycle_)
-                return ptr_ - it.ptr_;
-            else
-                return ptr_ - it.ptr_ + (cycle_ ? size_ : -1 * size_);
-        }
+        bool operator==(const Iterator& other) const { return offset_ == other.offset_; }
+        bool operator!=(const Iterator& other) const { return offset_ != other.offset_; }
+        bool operator<(const Iterator& other) const { return *this - other < 0; }
+        bool operator>(const Iterator& other) const { return *this - other > 0; }
+        bool operator<=(const Iterator& other) const { return *this - other <= 0; }
+        bool operator>=(const Iterator& other) const { return *this - other >= 0; }
+    private:
+        static constexpr difference_type kStep = ReverseIterator ? -1 : 1;
 
-        reference operator[](const difference_type n) {
-            return *(*this + n);
-        }
+        pointer start_;
+        size_type head_;
+        size_type capacity_;
+        difference_type offset_;
 
-        operator Iterator<const T, ReverseIterator>() const {
-            return Iterator<const T, ReverseIterator>(ptr_, start_, size_, cycle_);
+        // The element n steps past the logical offset, counted from front().
+        pointer slot(difference_type n) const {
+            return start_ + logical_slot(head_, static_cast<size_type>(offset_ + n - ReverseIterator), capacity_);
         }
-
-        bool operator==(const Iterator& other) const{ return this->ptr_ == other.ptr_ && this->cycle_ == other.cycle_; }
-        bool operator!=(const Iterator& other) { return !(*this == other); }
-        bool operator<(Iterator& other) const { return (other - *this) > 0; }
-        bool operator>(const Iterator& other) {return (other < *this); }
-        bool operator>=(const Iterator& other) { return !(*this < other); }
-        bool operator<=(const Iterator& other) { return !(*this > other); }
-        pointer operator->() { return ptr_; }
-    private:
-        pointer ptr_;
-        pointer start_;
-        size_type size_;
-        // cycle_ - is supporting flag for correct iterator comparisons
-        bool cycle_;
     };
 
     using iterator = Iterator<value_type>;
@@ -265,161 +524,265 @@ public:
     using reverse_iterator = Iterator<value_type, true>;
     using const_reverse_iterator = Iterator<const_value_type, true>;
 
-    CCircularBuffer(iterator& first, iterator& last) {
-        capacity_ = std::distance(first, last);
-        size_ = capacity_;
-        start_ = alloc_.allocate(capacity_);
+    CCircularBuffer(iterator& first, iterator& last, const Allocator& alloc = Allocator()) : alloc_(alloc) {
+        size_ = std::distance(first, last);
+        capacity_ = CapacityPolicy::round_up(size_);
+        start_ = this->allocate(capacity_);
         for (size_type i = 0; i < size_; ++i)
-            start_[i] = *first++;
+            construct(i, *first++);
         readptr_ = 0;
-        writeptr_ = 0;
+        writeptr_ = capacity_ == 0 ? 0 : CapacityPolicy::advance(0, size_, capacity_);
     }
 
-    CCircularBuffer(const std::initializer_list<T>& il) {
-        start_ = alloc_.allocate(il.size());
+    CCircularBuffer(const std::initializer_list<T>& il, const Allocator& alloc = Allocator()) : alloc_(alloc) {
         size_ = il.size();
-        capacity_ = il.size();
+        capacity_ = CapacityPolicy::round_up(size_);
+        start_ = this->allocate(capacity_);
         readptr_ = 0;
-        writeptr_ = 0;
+        writeptr_ = capacity_ == 0 ? 0 : CapacityPolicy::advance(0, size_, capacity_);
         typename std::initializer_list<T>::iterator it = il.begin();
         for (size_type i = 0; i < size_; ++i)
-            start_[i] = it[i];
+            construct(i, it[i]);
     }
 
-    CCircularBuffer<T>& operator=(const std::initializer_list<T>& il) {
-        if (il.size() <= capacity_) {
-            typename CCircularBuffer<T>::iterator it1 = this->begin();
-            typename std::initializer_list<T>::iterator it2 = il.begin();
-            for (; it2 != il.end(); ++it1, ++it2)
-                *it1 = *it2;
-            writeptr_ = il.size() % size_;
-            size_ = il.size();
-        } else {
-            CCircularBuffer<T> temp(il);
-            this->swap(temp);
-        }
+    CCircularBuffer& operator=(const std::initializer_list<T>& il) {
+        this->assign(il.begin(), il.end());
 
         return *this;
     }
 
-    iterator begin() { return iterator(&start_[readptr_], start_, capacity_, false); }
+    iterator begin() { return iterator(start_, this->head(), capacity_, 0); }
 
-    iterator end() {
-        if (size_ == capacity_){
-            iterator temp(&start_[readptr_], start_, capacity_, true);
-            return temp;
-        } else {
-            if (writeptr_ < readptr_) {
-                iterator temp(&start_[writeptr_], start_, capacity_, true);
-                return temp;
-            }
-            iterator temp(&start_[writeptr_], start_, capacity_, false);
-            return temp;
+    iterator end() { return iterator(start_, this->head(), capacity_, size_); }
+
+    const_iterator begin() const { return this->cbegin(); }
+
+    const_iterator end() const { return this->cend(); }
+
+    const_iterator cbegin() const { return const_iterator(start_, this->head(), capacity_, 0); }
+
+    const_iterator cend() const { return const_iterator(start_, this->head(), capacity_, size_); }
+
+    reverse_iterator rbegin() { return reverse_iterator(start_, this->head(), capacity_, size_); }
+
+    reverse_iterator rend() { return reverse_iterator(start_, this->head(), capacity_, 0); }
+
+    const_reverse_iterator crbegin() const { return const_reverse_iterator(start_, this->head(), capacity_, size_); }
+
+    const_reverse_iterator crend() const { return const_reverse_iterator(start_, this->head(), capacity_, 0); }
+
+    void push_back(const value_type& value) { this->emplace_back(value); }
+
+    void push_back(value_type&& value) { this->emplace_back(std::move(value)); }
+
+    void push_front(const value_type& value) { this->emplace_front(value); }
+
+    void push_front(value_type&& value) { this->emplace_front(std::move(value)); }
+
+    // Constructs the element right in its slot. A full buffer assigns over its oldest element instead,
+    // after the new value is built, so args may refer to that element.
+    template<typename... Args>
+    iterator emplace_back(Args&&... args) {
+        if (size_ == capacity_ && capacity_ != 0) {
+            StatsPolicy::add_overwrites(1);
+            start_[index(writeptr_)] = value_type(std::forward<Args>(args)...);
+            count_advance(readptr_, 1);
+            count_advance(writeptr_, 1);
+            readptr_ = CapacityPolicy::next(readptr_, capacity_);
+            writeptr_ = CapacityPolicy::next(writeptr_, capacity_);
+
+            return iterator(start_, this->head(), capacity_, size_ - 1);
         }
+        construct(writeptr_, std::forward<Args>(args)...);
+        count_advance(writeptr_, 1);
+        writeptr_ = CapacityPolicy::next(writeptr_, capacity_);
+        size_++;
+        StatsPolicy::record_size(size_);
+
+        return iterator(start_, this->head(), capacity_, size_ - 1);
     }
 
-    const_iterator cbegin() const { return const_iterator(&start_[readptr_], start_, capacity_, false); }
+    // Constructs the element right in its slot. A full buffer assigns over its newest element instead.
+    template<typename... Args>
+    iterator emplace_front(Args&&... args) {
+        if (size_ == capacity_ && capacity_ != 0) {
+            StatsPolicy::add_overwrites(1);
+            start_[index(CapacityPolicy::prev(writeptr_, capacity_))] = value_type(std::forward<Args>(args)...);
+            count_retreat(readptr_, 1);
+            count_retreat(writeptr_, 1);
+            readptr_ = CapacityPolicy::prev(readptr_, capacity_);
+            writeptr_ = CapacityPolicy::prev(writeptr_, capacity_);
 
-    const_iterator cend() const {
-        if (size_ == capacity_){
-            const_iterator temp(&start_[readptr_], start_, capacity_, true);
-            return temp;
-        } else {
-            if (writeptr_ < readptr_) {
-                const_iterator temp(&start_[writeptr_], start_, capacity_, true);
-                return temp;
-            }
-            const_iterator temp(&start_[writeptr_], start_, capacity_, false);
-            return temp;
+            return this->begin();
         }
+        size_t pos = CapacityPolicy::prev(readptr_, capacity_);
+        construct(pos, std::forward<Args>(args)...);
+        count_retreat(readptr_, 1);
+        readptr_ = pos;
+        size_++;
+        StatsPolicy::record_size(size_);
+
+        return this->begin();
     }
 
-    reverse_iterator rbegin() {
-        if (size_ == capacity_) {
-            reverse_iterator temp(&start_[readptr_], start_, capacity_, true);
-            ++temp;
-            return temp;
-        } else {
-            if (writeptr_ < readptr_) {
-                reverse_iterator temp(&start_[writeptr_], start_, capacity_, true);
-                ++temp;
-                return temp;
-            }
-            reverse_iterator temp(&start_[writeptr_], start_, capacity_, false);
-            ++temp;
-            return temp;
+    void pop_front() {
+        if (!empty()) {
+            size_t read = readptr_;
+            destroy(readptr_);
+            count_advance(readptr_, 1);
+            readptr_ = CapacityPolicy::next(readptr_, capacity_);
+            size_--;
+            decommit_slots(read, 1);
         }
     }
 
-    reverse_iterator rend() {
-        reverse_iterator temp(&start_[readptr_], start_, capacity_, false);
-        ++temp;
-        return temp;
+    void pop_back() {
+        if (!empty()) {
+            count_retreat(writeptr_, 1);
+            writeptr_ = CapacityPolicy::prev(writeptr_, capacity_);
+            destroy(writeptr_);
+            size_--;
+            decommit_slots(writeptr_, 1);
+        }
     }
 
-    const_reverse_iterator crbegin() const {
-        if (size_ == capacity_) {
-            const_reverse_iterator temp(&start_[readptr_], start_, capacity_, true);
-            ++temp;
-            return temp;
-        } else {
-            if (writeptr_ < readptr_) {
-                const_reverse_iterator temp(&start_[writeptr_], start_, capacity_, true);
-                ++temp;
-                return temp;
-            }
-            const_reverse_iterator temp(&start_[writeptr_], start_, capacity_, false);
-            ++temp;
-            return temp;
+    // Appends [first, last) with at most two contiguous copies. When the range does not fit,
+    // the oldest elements are overwritten as with push_back, and only the last capacity() values are kept.
+    template<typename ForwardIterator, typename = typename std::iterator_traits<ForwardIterator>::iterator_category>
+    void push_back(ForwardIterator first, ForwardIterator last) {
+        size_type n = std::distance(first, last);
+        if (n > capacity_) {
+            std::advance(first, n - capacity_);
+            n = capacity_;
+        }
+        if (n == 0)
+            return;
+        if (size_ + n > capacity_) {
+            StatsPolicy::add_overwrites(size_ + n - capacity_);
+            destroy_front(size_ + n - capacity_);
+        }
+        size_type write = index(writeptr_);
+        size_type head = std::min(n, capacity_ - write);
+        first = construct_slots(first, head, start_ + write);
+        construct_slots(first, n - head, start_);
+        count_advance(writeptr_, n);
+        writeptr_ = CapacityPolicy::advance(writeptr_, n, capacity_);
+        size_ += n;
+        StatsPolicy::record_size(size_);
+    }
+
+    void push_back(const_pointer data, size_type n) { this->push_back(data, data + n); }
+
+    // Removes up to n elements from the front, returns how many were removed.
+    size_type pop_front(size_type n) {
+        n = std::min(n, size_);
+        destroy_front(n);
+
+        return n;
+    }
+
+    // Copies up to n elements from the front into out without removing them, returns how many were copied.
+    template<typename OutputIterator>
+    size_type copy_out(OutputIterator out, size_type n) const {
+        n = std::min(n, size_);
+        const_array_range one = this->array_one();
+        size_type head = std::min(n, one.second);
+        out = copy_from_slots(one.first, head, out);
+        copy_from_slots(start_, n - head, out);
+
+        return n;
+    }
+
+    // Moves up to n elements from the front into out, returns how many were read.
+    template<typename OutputIterator>
+    size_type read(OutputIterator out, size_type n) {
+        return this->pop_front(this->copy_out(out, n));
+    }
+
+    // Hands up to max_n front elements to fn(pointer, count) as at most two contiguous spans,
+    // then removes everything fn consumed in one step. fn may move out of the elements.
+    // If fn returns a count smaller than the span it got, only that many are consumed and the drain stops;
+    // a void fn consumes every span. Returns how many elements were removed.
+    template<typename Func>
+    size_type consume(size_type max_n, Func&& fn) {
+        max_n = std::min(max_n, size_);
+        array_range one = this->array_one();
+        size_type head = std::min(max_n, one.second);
+        size_type done = consume_span(one.first, head, fn);
+        if (done == head && max_n != head)
+            done += consume_span(start_, max_n - head, fn);
+        destroy_front(done);
+
+        return done;
+    }
+
+    template<typename Func>
+    size_type consume_all(Func&& fn) { return this->consume(size_, std::forward<Func>(fn)); }
+
+#ifdef __linux__
+    // Reads up to max bytes from fd straight into the free space with one readv(), no overwriting.
+    // Returns what readv() returned; 0 without a call when max is 0 or the buffer is full.
+    ssize_t read_from_fd(int fd, size_type max) {
+        static_assert(sizeof(T) == 1 && std::is_trivially_copyable_v<T>, "read_from_fd needs a byte buffer");
+        max = std::min(max, this->space_left());
+        if (max == 0)
+            return 0;
+        size_type write = index(writeptr_);
+        size_type head = std::min(max, capacity_ - write);
+        iovec iov[2] = {{start_ + write, head}, {start_, max - head}};
+        ssize_t n = readv(fd, iov, max == head ? 1 : 2);
+        if (n > 0) {
+            count_advance(writeptr_, n);
+            writeptr_ = CapacityPolicy::advance(writeptr_, n, capacity_);
+            size_ += n;
+            StatsPolicy::record_size(size_);
         }
-    }
 
-    const_reverse_iterator crend() const {
-        const_reverse_iterator temp(&start_[readptr_], start_, capacity_, false);
-        ++temp;
-        return temp;
+        return n;
     }
 
-    void push_back(const value_type& value) {
-        *(start_ + writeptr_) = value;
-        writeptr_ = (writeptr_ + 1) % capacity_;
-        if (size_ == capacity_)
-            readptr_ = (readptr_ + 1 ) % capacity_;
-        else
-            size_++;
+    // Writes up to max bytes from the front to fd with one writev() and removes what was written.
+    // Returns what writev() returned; 0 without a call when max is 0 or the buffer is empty.
+    ssize_t write_to_fd(int fd, size_type max) {
+        static_assert(sizeof(T) == 1 && std::is_trivially_copyable_v<T>, "write_to_fd needs a byte buffer");
+        max = std::min(max, size_);
+        if (max == 0)
+            return 0;
+        array_range one = this->array_one();
+        size_type head = std::min(max, one.second);
+        iovec iov[2] = {{one.first, head}, {start_, max - head}};
+        ssize_t n = writev(fd, iov, max == head ? 1 : 2);
+        if (n > 0)
+            destroy_front(n);
+
+        return n;
     }
+#endif
 
-    void push_front(const value_type& value) {
+    // The first contiguous part of the stored elements, starting at front().
+    array_range array_one() {
+        size_type read = index(readptr_);
 
-        if (readptr_ == 0)
-            readptr_ = capacity_ - 1;
-        else
-            readptr_--;
-        *(start_ + readptr_) = value;
-        if (size_ == capacity_)
-            writeptr_ = (writeptr_ == 0 ? capacity_ - 1 : writeptr_ - 1);
-        else
-            size_++;
+        return array_range(start_ + read, std::min(size_, capacity_ - read));
+    }
 
+    // The wrapped part of the stored elements, starting at the beginning of the storage. Empty if nothing wraps.
+    array_range array_two() {
+        size_type read = index(readptr_);
+
+        return array_range(start_, size_ - std::min(size_, capacity_ - read));
     }
 
-    void pop_front() {
-        if (!empty()) {
-            readptr_++;
-            if (readptr_ == size_)
-                readptr_ = 0;
-            size_--;
-        }
+    const_array_range array_one() const {
+        size_type read = index(readptr_);
+
+        return const_array_range(start_ + read, std::min(size_, capacity_ - read));
     }
 
-    void pop_back() {
-        if (!empty()) {
-            if (writeptr_ == 0)
-                writeptr_ = capacity_ - 1;
-            else
-                writeptr_--;
-            size_--;
-        }
+    const_array_range array_two() const {
+        size_type read = index(readptr_);
+
+        return const_array_range(start_, size_ - std::min(size_, capacity_ - read));
     }
 
     reference front() { return *this->begin(); }
@@ -431,96 +794,35 @@ public:
         return *temp;
     }
 
+    const_reference front() const { return start_[index(readptr_)]; }
+
+    const_reference back() const { return start_[index(CapacityPolicy::prev(writeptr_, capacity_))]; }
+
     void clear() {
+        destroy_front(size_);
         writeptr_ = 0;
         readptr_ = 0;
-        size_ = 0;
-        for (int i = 0; i < capacity_; ++i)
-            alloc_.destroy(start_ + i);
     }
 
+    // Without enough free space the elements right before p are overwritten,
+    // see insert_from() for the exact rules.
     iterator insert(const_iterator p, const value_type& value) {
-        if (p == this->cbegin()) {
-            iterator temp = this->begin() + (p - this->cbegin());
-
-            return temp;
-        }
-        if (full()) {
-            iterator temp = this->begin() + (p - this->cbegin());
-            --temp;
-            *temp = value;
-
-            return temp;
-        } else {
-            iterator temp = this->end();
-            for (; p != temp; --temp)
-                *temp = *(temp - 1);
-            *temp = value;
-            size_++;
-            writeptr_ = (writeptr_ + 1) % capacity_;
-
-            return temp;
-
-        }
+        return this->insert_from(p - this->cbegin(), 1, [&value]() -> const value_type& { return value; });
+    }
 
+    iterator insert(const_iterator p, value_type&& value) {
+        return this->insert_from(p - this->cbegin(), 1, [&value]() -> value_type&& { return std::move(value); });
     }
 
     iterator insert(const_iterator p, const size_type& n, const value_type& value) {
-        size_type ins = std::min<size_t>(n, (p - this->cbegin()) + this->space_left());
-        size_type overwrite = std::min<int32_t>(p - this->cbegin(), std::max<int32_t>(0, n - this->space_left()));
-        if (this->full()) {
-            iterator temp = this->begin() + (p - this->cbegin());
-            for (size_type i = 1; i <= overwrite; ++i) {
-                *(temp - i) = value;
-            }
-
-            return temp;
-        } else {
-            iterator temp = this->begin() + (p - this->cbegin());
-            size_t shift = this->end() - temp;
-            for (size_t i = shift; i > 0; --i)
-                *(temp + i - 1 + (ins - overwrite)) = *(temp + i - 1);
-            for (size_t i = 0; i < (ins - overwrite); ++i)
-                *(temp + i) = value;
-            writeptr_ = (writeptr_ + ins - overwrite) % capacity_;
-            size_ = size_ + ins - overwrite;
-            if (overwrite != 0) {
-                for (size_t i = 1; i <= overwrite; ++i)
-                    *(temp - i) = value;
-            }
-
-            return temp - overwrite;
-        }
+        return this->insert_from(p - this->cbegin(), n, [&value]() -> const value_type& { return value; });
     }
 
-    template<typename InputIterator>
+    template<typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category>
     iterator insert(const_iterator p, InputIterator first, InputIterator last) {
-        size_t len = std::distance(first, last);
-        size_t ins = std::min<size_t>(len,
-                                      p - this->cbegin() + this->space_left());
-        size_t overwrite = std::min<int32_t>(p - this->cbegin(),
-                                             std::max<int32_t>(0, static_cast<int32_t>(len - this->space_left())));
-        if (full()) {
-            iterator temp = this->begin() + (p - this->cbegin());
-            for (size_t i = 0; i < len - ins; ++i, ++first);
-            for (size_t i = 0; i < overwrite; ++i)
-                *(temp - ins + i) = *first++;
+        size_type len = std::distance(first, last);
 
-            return temp;
-        } else {
-            iterator temp = this->begin() + (p - this->cbegin());
-            size_t shift = this->end() - temp;
-            for (size_t i = shift; i > 0; --i)
-                *(temp + i - 1 + (ins - overwrite)) = *(temp + i - 1);
-            writeptr_ = (writeptr_ + ins - overwrite) % capacity_;
-            size_ = size_ + ins - overwrite;
-            temp -= overwrite;
-            for (size_t i = 0; i < len - ins; ++i, ++first);
-            for (size_t i = 0; i < ins; ++i)
-                *(temp + i) = *first++;
-
-            return temp;
-        }
+        return this->insert_from(p - this->cbegin(), len, [&first]() -> decltype(auto) { return *first++; });
     }
 
     iterator insert(const_iterator p, std::initializer_list<T> il) {
@@ -531,57 +833,20 @@ public:
         if (p == this->cend())
             return this->end();
 
-        if (p == this->cbegin()) {
-            readptr_++;
-            size_--;
-            return this->begin();
-        }
-
-        iterator temp = this->begin() + (p - this->cbegin());
-        for (; temp != this->end(); ++temp)
-            *temp = *(temp + 1);
-        size_--;
-        if (writeptr_ == 0)
-            writeptr_ = size_;
-        else
-            writeptr_--;
-
-        return this->begin() + (p - this->cbegin());
+        return this->erase_n(p - this->cbegin(), 1);
     }
 
     iterator erase(const_iterator q1, const_iterator q2) {
-        if (q1 == q2)
-            return this->begin();
-        if (q1 == this->cbegin()) {
-            readptr_ = q2 - this->cbegin();
-            size_ -= std::distance(q1, q2);
-
-            return this->begin();
-        }
-        if (q2 == this->cend()) {
-            size_ -= std::distance(q1, q2);
-            writeptr_ = size_;
-
-            return this->end() - 1;
-        }
-        size_t rem = std::distance(q1, q2);
-        iterator temp_q1 = this->begin() + (q1 - this->cbegin());
-        iterator temp_q2 = this->begin() + (q2 - this->cbegin());
-        for (; temp_q2 != this->end(); ++temp_q2)
-            *temp_q1++ = *temp_q2;
-        size_ -= rem;
-        writeptr_ = size_;
-
-        return this->end() - 1;
+        return this->erase_n(q1 - this->cbegin(), q2 - q1);
     }
 
-    template<typename InputIterator>
+    template<typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category>
     void assign(InputIterator first, InputIterator last) {
         this->clear();
-        if (std::distance(first, last) > capacity_)
-            this->resize(std::distance(first, last));
-        for (; first != last; ++first)
-            this->push_back(*first);
+        size_type n = std::distance(first, last);
+        if (n > capacity_)
+            this->resize(n);
+        this->push_back(first, last);
     }
 
     void assign(std::initializer_list<T> il) {
@@ -593,28 +858,26 @@ public:
         if (n > capacity_)
             this->resize(n);
         for (size_t i = 0; i < n; ++i)
-            this->push_back(value);
+            this->emplace_back(value);
     }
 
     template<typename... Args>
     iterator emplace(const_iterator p, Args&&... args) {
-        this->insert(p, value_type(std::forward<Args>(args)...));
-    }
+        if (p == this->cend() && !this->full())
+            return this->emplace_back(std::forward<Args>(args)...);
 
-    template<typename... Args>
-    iterator emplace_back(Args&&... args) {
-        this->push_back(value_type(std::forward<Args>(args)...));
+        return this->insert(p, value_type(std::forward<Args>(args)...));
     }
 
-    reference operator[](size_type index) {
-        return *(this->begin() + index);
-    }
+    reference operator[](size_type index) { return start_[this->logical_slot(index)]; }
 
-    reference at(size_type index) {
-        return *(this->begin() + index);
-    }
+    const_reference operator[](size_type index) const { return start_[this->logical_slot(index)]; }
+
+    reference at(size_type index) { return start_[this->logical_slot(index)]; }
+
+    const_reference at(size_type index) const { return start_[this->logical_slot(index)]; }
 
-    bool operator==(const CCircularBuffer<T>& other) const {
+    bool operator==(const CCircularBuffer& other) const {
         if (this->size_ != other.size_)
             return false;
         if (std::equal(this->cbegin(), this->cend(), other.cbegin(), other.cend()))
@@ -623,9 +886,12 @@ public:
         return false;
     }
 
-    bool operator!=(const CCircularBuffer<T>& other) const { return !(*this == other); }
+    bool operator!=(const CCircularBuffer& other) const { return !(*this == other); }
 
-    void swap(CCircularBuffer<T, Allocator>& other) {
+    // Without propagate_on_container_swap both allocators must be equal, as for the standard containers.
+    void swap(CCircularBuffer& other) noexcept {
+        if constexpr (alloc_traits::propagate_on_container_swap::value)
+            std::swap(alloc_, other.alloc_);
         std::swap(start_, other.start_);
         std::swap(readptr_, other.readptr_);
         std::swap(writeptr_, other.writeptr_);
@@ -637,32 +903,93 @@ public:
 
     size_type capacity() const { return capacity_; }
 
-    size_type max_size() const { return alloc_.max_size(); }
+    size_type max_size() const { return alloc_traits::max_size(alloc_); }
 
     bool full() const {return size_ == capacity_; }
 
-    bool empty() { return size_ == 0; }
+    bool empty() const { return size_ == 0; }
 
     size_type space_left() const { return capacity_ - size_; }
 
+    // Counters collected by StatsPolicy, all zero with CNoStats. Safe to call from another thread.
+    CBufferStats stats() const { return StatsPolicy::snapshot(); }
+
+    // Keeps the first elements that fit into the new capacity, moving them with at most two relocations.
     void resize(const size_type newSize) {
-        if (newSize == capacity_)
+        if (CapacityPolicy::round_up(newSize) == capacity_)
             return;
-        else if (newSize < capacity_) {
-            iterator first = this->begin();
-            iterator last = this->begin() + newSize - 1;
-            CCircularBuffer<T> temp(first, last);
-            this->swap(temp);
-        } else {
-            CCircularBuffer temp(newSize);
-            for (iterator it = this->begin(); it != this->end(); ++it)
-                temp.push_back(*it);
-            this->swap(temp);
+        StatsPolicy::add_resize();
+        CCircularBuffer temp(newSize, alloc_);
+        size_type n = std::min(size_, temp.capacity_);
+        array_range one = this->array_one();
+        array_range two = this->array_two();
+        size_type head = std::min(n, one.second);
+        relocate_slots(one.first, head, temp.start_);
+        relocate_slots(two.first, n - head, temp.start_ + head);
+        temp.size_ = n;
+        temp.writeptr_ = temp.capacity_ == 0 ? 0 : CapacityPolicy::advance(0, n, temp.capacity_);
+        readptr_ = capacity_ == 0 ? 0 : CapacityPolicy::advance(readptr_, n, capacity_);
+        size_ -= n;
+        this->swap(temp);
+    }
+
+private:
+    iterator iterator_at(size_type offset) { return offset == size_ ? this->end() : this->begin() + offset; }
+
+    // Inserts len values taken from next() before the element at offset. Without enough free space
+    // the elements right before offset are overwritten, and if that is still not enough
+    // the first values are skipped, so the elements from offset to the end always stay.
+    // New room is opened on whichever side has fewer elements to move.
+    template<typename Source>
+    iterator insert_from(size_type offset, size_type len, Source&& next) {
+        size_type ins = std::min(len, offset + this->space_left());
+        size_type overwrite = len > this->space_left() ? std::min(offset, len - this->space_left()) : 0;
+        size_type grow = ins - overwrite;
+        size_type keep = offset - overwrite;
+        for (size_type i = ins; i < len; ++i)
+            next();
+        StatsPolicy::add_overwrites(overwrite);
+        size_type oldSize = size_;
+        bool front = keep < size_ - offset;
+        if (grow != 0 && front)
+            open_front(keep, grow);
+        else if (grow != 0)
+            open_back(offset, grow);
+        for (size_type i = keep; i < offset + grow; ++i) {
+            if (front ? i < grow : i >= oldSize)
+                alloc_traits::construct(alloc_, slot(i), next());
+            else
+                *slot(i) = next();
         }
+
+        return iterator_at(keep);
     }
 
+    // Closes the gap on whichever side has fewer elements to move.
+    iterator erase_n(size_type offset, size_type n) {
+        if (n == 0)
+            return iterator_at(offset);
+        size_type tail = size_ - offset - n;
+        if (offset < tail) {
+            move_slots(readptr_, position(n), offset, true);
+            destroy_front(n);
+            StatsPolicy::add_shifted(offset);
+        } else {
+            move_slots(position(offset + n), position(offset), tail, false);
+            destroy_back(n);
+            StatsPolicy::add_shifted(tail);
+        }
+
+        return iterator_at(offset);
+    }
 };
 
-template<typename T>
-void swap(CCircularBuffer<T>& a, CCircularBuffer<T>& b) { a.swap(b); }
+template<typename T, typename Allocator, typename CapacityPolicy, typename StatsPolicy>
+void swap(CCircularBuffer<T, Allocator, CapacityPolicy, StatsPolicy>& a,
+          CCircularBuffer<T, Allocator, CapacityPolicy, StatsPolicy>& b) {
+    a.swap(b);
+}
 
+// Takes its storage from a std::pmr::memory_resource, e.g. a monotonic arena that frees every buffer at once.
+template<typename T, typename CapacityPolicy = CModuloCapacity, typename StatsPolicy = CNoStats>
+using CPmrCircularBuffer = CCircularBuffer<T, std::pmr::polymorphic_allocator<T>, CapacityPolicy, StatsPolicy>;
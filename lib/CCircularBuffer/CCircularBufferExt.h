@@ -1,648 +1,270 @@
 #pragma once
+#include "CCircularBuffer.h"
+#include "CGrowthPolicy.h"
+
 #include <iostream>
 
 const size_t kCapacityRate = 2;
 
-template<typename T, typename Allocator = std::allocator<T>>
-class CCircularBufferExt {
+// Bytes taken by the element storage now and at most since construction.
+struct CBufferFootprint {
+    size_t current;
+    size_t peak;
+};
+
+// Circular buffer that grows instead of overwriting: every operation that would not fit
+// first moves the elements into storage of the size GrowthPolicy picks.
+// Operations that remove elements ask ShrinkPolicy whether to move them into smaller storage,
+// but never below the capacity requested with reserve().
+template<typename T, typename Allocator = std::allocator<T>, typename GrowthPolicy = CGeometricGrowth<kCapacityRate>,
+         typename ShrinkPolicy = CNoShrink, typename StatsPolicy = CNoStats>
+class CCircularBufferExt : public CCircularBuffer<T, Allocator, CModuloCapacity, StatsPolicy> {
 private:
-    size_t capacity_;
-    size_t size_;
-    T* start_;
-    uint32_t readptr_;
-    uint32_t writeptr_;
-    Allocator alloc_;
-public:
-    using value_type = T;
-    using const_value_type = const T;
-    using reference = T&;
-    using const_reference = const T&;
-    using pointer = T*;
-    using const_pointer = const T*;
-    using size_type = std::size_t;
-    using difference_type = std::ptrdiff_t;
-
-    CCircularBufferExt() : capacity_(0), start_(nullptr), readptr_(0), writeptr_(0), size_(0) {}
-
-    CCircularBufferExt(size_t size) : capacity_(size) {
-        start_ = alloc_.allocate(size);
-        readptr_ = 0;
-        writeptr_ = 0;
-        size_ = 0;
-    }
+    using base = CCircularBuffer<T, Allocator, CModuloCapacity, StatsPolicy>;
 
-    CCircularBufferExt(size_t size, T sample) : capacity_(size) {
-        start_ = alloc_.allocate(size);
-        readptr_ = 0;
-        writeptr_ = 0;
-        size_ = size;
-        for (; writeptr_ != size; start_[writeptr_] = sample, writeptr_++);
-        writeptr_ = 0;
-    }
+    GrowthPolicy growth_;
+    ShrinkPolicy shrink_;
+    size_t reserved_ = 0;
+    size_t peak_ = 0;
 
-    explicit CCircularBufferExt(const CCircularBufferExt<T>& other) {
-        readptr_ = other.readptr_;
-        writeptr_ = other.writeptr_;
-        size_ = other.size_;
-        capacity_ = other.capacity_;
-        start_ = alloc_.allocate(other.capacity_);
-        for (size_type i = 0; i < other.size_; ++i) {
-            start_[i] = other.start_[i];
-        }
+    void reserve_more(size_t n) {
+        if (this->size() + n > this->capacity())
+            this->resize(growth_.next_capacity(this->capacity(), this->size() + n));
     }
 
-    virtual ~CCircularBufferExt() {
-        alloc_.deallocate(start_, capacity_);
+    void shrink_if_sparse() {
+        size_t capacity = std::max(shrink_.shrink_capacity(this->capacity(), this->size()), reserved_);
+        if (capacity < this->capacity())
+            this->resize(capacity);
     }
+public:
+    using typename base::value_type;
+    using typename base::const_value_type;
+    using typename base::reference;
+    using typename base::const_reference;
+    using typename base::pointer;
+    using typename base::const_pointer;
+    using typename base::size_type;
+    using typename base::difference_type;
+    using typename base::iterator;
+    using typename base::const_iterator;
+    using typename base::reverse_iterator;
+    using typename base::const_reverse_iterator;
 
-    CCircularBufferExt& operator=(const CCircularBufferExt<value_type>& other) {
-        this->clear();
-        if (capacity_ < other.capacity_) {
-            alloc_.deallocate(start_, capacity_);
-            start_ = alloc_.allocate(other.capacity_);
-            capacity_ = other.capacity_;
-            size_ = other.size_;
-            for (size_type i = 0; i < other.size_; ++i)
-                start_[i] = other.start_[i];
-            readptr_ = other.readptr_;
-            writeptr_ = other.writeptr_;
-        } else {
-            for (size_type i = 0; i < other.size_; ++i)
-                this->push_back(other.start_[i]);
-        }
+    using base::base;
 
-        return *this;
-    }
+    CCircularBufferExt() = default;
 
-    template<typename Tp, bool ReverseIterator = false>
-    class Iterator {
-    public:
-        using value_type = Tp;
-        using reference = Tp&;
-        using pointer = Tp*;
-        using difference_type = std::ptrdiff_t;
-        using iterator_category = std::random_access_iterator_tag;
-
-        Iterator(pointer ptr, pointer start, size_type size, bool cycle) {
-            ptr_ = ptr;
-            start_ = start;
-            size_ = size;
-            cycle_ = cycle;
-        }
-
-        ~Iterator() = default;
-
-        reference operator*() { return *ptr_; }
-
-        Iterator& operator=(const Iterator<Tp, ReverseIterator>& it) {
-            ptr_ = it.ptr_;
-            start_ = it.start_;
-            size_ = it.size_;
-            cycle_ = it.cycle_;
-
-            return *this;
-        }
-
-        Iterator operator++(int) {
-            Iterator temp = *this;
-            if (ReverseIterator) {
-                --(*this);
-            } else
-                ++(*this);
-
-            return temp;
-        }
-
-        Iterator& operator++() {
-            if (ReverseIterator) {
-                if (ptr_ == start_) {
-                    ptr_ = start_ + size_ - 1;
-                    cycle_ = !cycle_;
-                } else
-                    --(this->ptr_);
-            } else {
-                if (ptr_ - start_ == size_ - 1) {
-                    ptr_ = start_;
-                    cycle_ = !cycle_;
-                } else
-                    ++(this->ptr_);
-            }
-
-            return *this;
-        }
-
-        Iterator operator--(int) {
-            Iterator temp = *this;
-            if (ReverseIterator)
-                ++(*this);
-            else
-                --(*this);
-
-            return temp;
-        }
-
-        Iterator& operator--() {
-            if (ReverseIterator) {
-                if (ptr_ - start_ == size_ - 1) {
-                    ptr_ = start_;
-                    cycle_ = !cycle_;
-                } else
-                    ++(this->ptr_);
-            } else {
-                if (ptr_ == start_) {
-                    ptr_ = start_ + size_ - 1;
-                    cycle_ = !cycle_;
-                } else
-                    --(this->ptr_);
-            }
-
-            return *this;
-        }
-
-        Iterator& operator+=(const difference_type n) {
-            if (ReverseIterator) {
-                *this -= -1 * (n);
-            } else {
-                bool sign = n < 0;
-                difference_type shift;
-                if (sign)
-                    shift = -1 * ((-1 * n) % size_);
-                else
-                    shift = n % size_;
-                if (!sign) {
-                    if (shift > start_ + size_ - 1 - ptr_)
-                        cycle_ = !cycle_;
-                    shift = (ptr_ - start_ + shift) % size_;
-                    ptr_ = start_ + shift;
-                } else {
-                    if (shift + ptr_ < start_)
-                        cycle_ = !cycle_;
-                    shift = (ptr_ - start_ + (size_ + shift)) % size_;
-                    ptr_ = start_ + shift;
-                }
-            }
-
-            return *this;
-        }
-
-        Iterator operator+(const difference_type& n) {
-            Iterator temp = *this;
-
-            return temp += n;
-        }
-
-        friend Iterator operator+(const difference_type n, Iterator& it) {
-            Iterator temp = it;
-            if (ReverseIterator)
-                return temp -= n;
-            else
-                return temp += n;
-        }
-
-        Iterator operator-=(const difference_type n) {
-            if (ReverseIterator) {
-                bool sign = n < 0;
-                difference_type shift;
-                if (sign)
-                    shift = -1 * ((-1 * n) % size_);
-                else
-                    shift = n % size_;
-                if (!sign) {
-                    if (shift > start_ + size_ - 1 - ptr_)
-                        cycle_ = !cycle_;
-                    shift = (ptr_ - start_ + shift) % size_;
-                    ptr_ = start_ + shift;
-                } else {
-                    if (shift + ptr_ < start_)
-                        cycle_ = !cycle_;
-                    shift = (ptr_ - start_ + (size_ + shift)) % size_;
-                    ptr_ = start_ + shift;
-                }
-            } else {
-                *this += -1 * (n);
-            }
-
-            return *this;
-        }
-
-        Iterator operator-(const difference_type n) {
-            Iterator temp = *this;
-
-            return (temp -= n);
-        }
-
-        difference_type operator-(const Iterator& it) {
-            if (cycle_ == it.cycle_)
-                return ptr_ - it.ptr_;
-            else
-                return ptr_ - it.ptr_ + (cycle_ ? size_ : -1 * size_);
-        }
-
-        reference operator[](const difference_type n) {
-            return *(*this + n);
-        }
-
-        operator Iterator<const T, ReverseIterator>() const {
-            return Iterator<const T, ReverseIterator>(ptr_, start_, size_, cycle_);
-        }
-
-        bool operator==(const Iterator& other) const{ return this->ptr_ == other.ptr_ && this->cycle_ == other.cycle_; }
-        bool operator!=(const Iterator& other) { return !(*this == other); }
-        bool operator<(Iterator& other) const { return (other - *this) > 0; }
-        bool operator>(const Iterator& other) {return (other < *this); }
-        bool operator>=(const Iterator& other) { return !(*this < other); }
-        bool operator<=(const Iterator& other) { return !(*this > other); }
-        pointer operator->() { return ptr_; }
-    private:
-        pointer ptr_;
-        pointer start_;
-        size_type size_;
-        // cycle_ - is supporting flag for correct iterator comparisons
-        bool cycle_;
-    };
-
-    using iterator = Iterator<value_type>;
-    using const_iterator = Iterator<const_value_type>;
-    using reverse_iterator = Iterator<value_type, true>;
-    using const_reverse_iterator = Iterator<const_value_type, true>;
-
-
-    CCircularBufferExt(iterator& first, iterator& last) {
-        capacity_ = std::distance(first, last);
-        size_ = capacity_;
-        start_ = alloc_.allocate(capacity_);
-        for (size_type i = 0; i < size_; ++i)
-            start_[i] = *first++;
-        readptr_ = 0;
-        writeptr_ = 0;
-    }
+    CCircularBufferExt(size_t size) : base(size) {}
 
-    CCircularBufferExt(std::initializer_list<T> il) {
-        start_ = alloc_.allocate(il.size());
-        size_ = il.size();
-        capacity_ = il.size();
-        readptr_ = 0;
-        writeptr_ = 0;
-        typename std::initializer_list<T>::iterator it = il.begin();
-        for (size_type i = 0; i < size_; ++i)
-            start_[i] = it[i];
-    }
+    CCircularBufferExt(size_t size, const GrowthPolicy& growth, const ShrinkPolicy& shrink = ShrinkPolicy())
+        : base(size), growth_(growth), shrink_(shrink) {}
+
+    CCircularBufferExt(const CCircularBufferExt& other) = default;
+
+    // Defaulted without noexcept, so the moves are exactly as noexcept as those of the base.
+    CCircularBufferExt(CCircularBufferExt&& other) = default;
+
+    CCircularBufferExt& operator=(const CCircularBufferExt& other) = default;
 
-    CCircularBufferExt<T>& operator=(std::initializer_list<T> il) {
-        if (il.size() <= capacity_) {
-            typename CCircularBufferExt<T>::iterator it1 = this->begin();
-            typename std::initializer_list<T>::iterator it2 = il.begin();
-            for (; it2 != il.end(); ++it1, ++it2)
-                *it1 = *it2;
-            writeptr_ = il.size() % size_;
-            size_ = il.size();
-        } else {
-            CCircularBufferExt<T> temp(il);
-            this->swap(temp);
-        }
+    CCircularBufferExt& operator=(CCircularBufferExt&& other) = default;
+
+    CCircularBufferExt& operator=(std::initializer_list<T> il) {
+        this->assign(il);
 
         return *this;
     }
 
-    iterator begin() { return iterator(&start_[readptr_], start_, capacity_, false); }
-
-    iterator end() {
-        if (size_ == capacity_){
-            iterator temp(&start_[readptr_], start_, capacity_, true);
-            return temp;
-        } else {
-            if (writeptr_ < readptr_) {
-                iterator temp(&start_[writeptr_], start_, capacity_, true);
-                return temp;
-            }
-            iterator temp(&start_[writeptr_], start_, capacity_, false);
-            return temp;
-        }
-    }
+    GrowthPolicy& growth_policy() { return growth_; }
 
-    const_iterator cbegin() const { return const_iterator(&start_[readptr_], start_, capacity_, false); }
-
-    const_iterator cend() const {
-        if (size_ == capacity_){
-            const_iterator temp(&start_[readptr_], start_, capacity_, true);
-            return temp;
-        } else {
-            if (writeptr_ < readptr_) {
-                const_iterator temp(&start_[writeptr_], start_, capacity_, true);
-                return temp;
-            }
-            const_iterator temp(&start_[writeptr_], start_, capacity_, false);
-            return temp;
-        }
-    }
+    const GrowthPolicy& growth_policy() const { return growth_; }
 
-    reverse_iterator rbegin() {
-        if (size_ == capacity_) {
-            reverse_iterator temp(&start_[readptr_], start_, capacity_, true);
-            ++temp;
-            return temp;
-        } else {
-            if (writeptr_ < readptr_) {
-                reverse_iterator temp(&start_[writeptr_], start_, capacity_, true);
-                ++temp;
-                return temp;
-            }
-            reverse_iterator temp(&start_[writeptr_], start_, capacity_, false);
-            ++temp;
-            return temp;
-        }
-    }
+    ShrinkPolicy& shrink_policy() { return shrink_; }
 
-    reverse_iterator rend() {
-        reverse_iterator temp(&start_[readptr_], start_, capacity_, false);
-        ++temp;
-        return temp;
+    const ShrinkPolicy& shrink_policy() const { return shrink_; }
+
+    CBufferFootprint footprint() const {
+        return CBufferFootprint{this->capacity() * sizeof(T), std::max(peak_, this->capacity()) * sizeof(T)};
     }
 
-    const_reverse_iterator crbegin() {
-        if (size_ == capacity_) {
-            const_reverse_iterator temp(&start_[readptr_], start_, capacity_, true);
-            ++temp;
-            return temp;
-        } else {
-            if (writeptr_ < readptr_) {
-                const_reverse_iterator temp(&start_[writeptr_], start_, capacity_, true);
-                ++temp;
-                return temp;
-            }
-            const_reverse_iterator temp(&start_[writeptr_], start_, capacity_, false);
-            ++temp;
-            return temp;
-        }
+    void swap(CCircularBufferExt& other) {
+        base::swap(other);
+        std::swap(growth_, other.growth_);
+        std::swap(shrink_, other.shrink_);
+        std::swap(reserved_, other.reserved_);
+        std::swap(peak_, other.peak_);
     }
 
-    const_reverse_iterator crend() {
-        const_reverse_iterator temp(&start_[readptr_], start_, capacity_, false);
-        ++temp;
-        return temp;
+    void resize(size_type newSize) {
+        peak_ = std::max(peak_, this->capacity());
+        base::resize(newSize);
     }
 
-    void push_back(const value_type& value) {
-        if (size_ == capacity_)
-            this->resize(capacity_ * kCapacityRate);
-        *(start_ + writeptr_) = value;
-        writeptr_ = (writeptr_ + 1) % capacity_;
-        if (size_ == capacity_)
-            readptr_ = (readptr_ + 1 ) % capacity_;
-        else
-            size_++;
+    // Makes sure that no reallocation happens until the buffer holds more than n elements,
+    // and that automatic shrinking keeps at least n slots.
+    void reserve(size_type n) {
+        reserved_ = n;
+        if (n > this->capacity())
+            this->resize(n);
     }
 
-    void push_front(const value_type& value) {
-        if (size_ == capacity_)
-            this->resize(capacity_ * kCapacityRate);
-        if (readptr_ == 0)
-            readptr_ = capacity_ - 1;
-        else
-            readptr_--;
-        *(start_ + readptr_) = value;
-        if (size_ == capacity_)
-            writeptr_ = (writeptr_ == 0 ? capacity_ - 1 : writeptr_ - 1);
-        else
-            size_++;
+    // Moves the elements into storage of exactly size() slots and drops the reserve() floor.
+    void shrink_to_fit() {
+        reserved_ = 0;
+        if (this->size() < this->capacity())
+            this->resize(this->size());
     }
 
     void pop_front() {
-        if (!empty()) {
-            readptr_++;
-            if (readptr_ == size_)
-                readptr_ = 0;
-            size_--;
-        }
+        base::pop_front();
+        this->shrink_if_sparse();
     }
 
     void pop_back() {
-        if (!empty()) {
-            if (writeptr_ == 0)
-                writeptr_ = capacity_ - 1;
-            else
-                writeptr_--;
-            size_--;
-        }
+        base::pop_back();
+        this->shrink_if_sparse();
     }
 
-    reference front() { return *this->begin(); }
-
-    reference back() {
-        iterator temp = this->end();
-        --temp;
+    size_type pop_front(size_type n) {
+        n = base::pop_front(n);
+        this->shrink_if_sparse();
 
-        return *temp;
+        return n;
     }
 
-    void clear() {
-        writeptr_ = 0;
-        readptr_ = 0;
-        size_ = 0;
-        for (int i = 0; i < capacity_; ++i)
-            alloc_.destroy(start_ + i);
+    template<typename OutputIterator>
+    size_type read(OutputIterator out, size_type n) {
+        return this->pop_front(this->copy_out(out, n));
     }
 
-    iterator insert(const_iterator p, const value_type& value) {
-        size_t ind = p - this->cbegin();
-        if (size_ == capacity_)
-            this->resize(capacity_ * kCapacityRate);
-        if (p == this->cbegin()) {
-            iterator temp = this->begin() + (p - this->cbegin());
+    template<typename Func>
+    size_type consume(size_type max_n, Func&& fn) {
+        size_type n = base::consume(max_n, std::forward<Func>(fn));
+        this->shrink_if_sparse();
 
-            return temp;
-        }
-        iterator temp = this->end();
-        for (; this->begin() + ind != temp; --temp)
-            *temp = *(temp - 1);
-        *temp = value;
-        size_++;
-        writeptr_ = (writeptr_ + 1) % capacity_;
+        return n;
+    }
 
-        return temp;
+    template<typename Func>
+    size_type consume_all(Func&& fn) { return this->consume(this->size(), std::forward<Func>(fn)); }
 
+#ifdef __linux__
+    // Grows like push_back() when the buffer is full, so a read never stops on lack of space.
+    ssize_t read_from_fd(int fd, size_type max) {
+        if (max != 0 && this->full())
+            this->reserve_more(1);
 
+        return base::read_from_fd(fd, max);
     }
 
-    iterator insert(const_iterator p, const size_type& n, const value_type& value) {
-        size_t ind = p - this->cbegin();
-        if (size_ + n > capacity_ && size_ + n <= capacity_ * kCapacityRate)
-            this->resize(capacity_ * 2);
-        else if (size_ + n > capacity_ * 2)
-            this->resize(capacity_ + n);
-
-        iterator temp = this->begin() + ind;
-        size_t shift = this->end() - temp;
-        for (size_t i = shift; i > 0; --i)
-            *(temp + i - 1 + n) = *(temp + i - 1);
-        for (size_t i = 0; i < n; ++i)
-            *(temp + i) = value;
-        writeptr_ = (writeptr_ + n) % capacity_;
-        size_ = size_ + n;
-
-        return temp;
+    ssize_t write_to_fd(int fd, size_type max) {
+        ssize_t n = base::write_to_fd(fd, max);
+        this->shrink_if_sparse();
 
+        return n;
     }
+#endif
 
-    template<typename InputIterator>
-    iterator insert(const_iterator p, InputIterator first, InputIterator last) {
-        size_t ind = p - this->cbegin();
-        size_t n = std::distance(first, last);
-        if (size_ + n > capacity_ && size_ + n <= capacity_ * kCapacityRate)
-            this->resize(capacity_ * kCapacityRate);
-        else if (size_ + n > capacity_ * kCapacityRate)
-            this->resize(capacity_ + n);
-
-        iterator temp = this->begin() + ind;
-        size_t shift = this->end() - temp;
-        for (size_t i = shift; i > 0; --i)
-            *(temp + i - 1 + n )= *(temp + i - 1);
-        writeptr_ = (writeptr_ + n) % capacity_;
-        size_ = size_ + n;
-        for (size_t i = 0; i < n; ++i)
-            *(temp + i) = *first++;
-
-        return temp;
-    }
-
-    iterator insert(const_iterator p, std::initializer_list<T> il) {
-        return this->insert(p, il.begin(), il.end());
+    void clear() {
+        base::clear();
+        this->shrink_if_sparse();
     }
 
     iterator erase(const_iterator p) {
-        if (p == this->cend())
-            return this->end();
-
-        if (p == this->cbegin()) {
-            readptr_++;
-            size_--;
-            return this->begin();
-        }
-
-        iterator temp = this->begin() + (p - this->cbegin());
-        for (; temp != this->end(); ++temp)
-            *temp = *(temp + 1);
-        size_--;
-        if (writeptr_ == 0)
-            writeptr_ = size_;
-        else
-            writeptr_--;
-
-        return this->begin() + (p - this->cbegin());
+        size_type ind = p - this->cbegin();
+        base::erase(p);
+        this->shrink_if_sparse();
+
+        return ind == this->size() ? this->end() : this->begin() + ind;
     }
 
     iterator erase(const_iterator q1, const_iterator q2) {
-        if (q1 == q2)
-            return this->begin();
-        if (q1 == this->cbegin()) {
-            readptr_ = q2 - this->cbegin();
-            size_ -= std::distance(q1, q2);
-
-            return this->begin();
-        }
-        if (q2 == this->cend()) {
-            size_ -= std::distance(q1, q2);
-            writeptr_ = size_;
-
-            return this->end() - 1;
-        }
-        size_t rem = std::distance(q1, q2);
-        iterator temp_q1 = this->begin() + (q1 - this->cbegin());
-        iterator temp_q2 = this->begin() + (q2 - this->cbegin());
-        for (; temp_q2 != this->end(); ++temp_q2)
-            *temp_q1++ = *temp_q2;
-        size_ -= rem;
-        writeptr_ = size_;
-
-        return this->end() - 1;
-    }
+        size_type ind = q1 - this->cbegin();
+        base::erase(q1, q2);
+        this->shrink_if_sparse();
 
-    template<typename InputIterator>
-    void assign(InputIterator first, InputIterator last) {
-        this->clear();
-        if (std::distance(first, last) > capacity_)
-            this->resize(std::distance(first, last));
-        for (; first != last; ++first)
-            this->push_back(*first);
+        return ind == this->size() ? this->end() : this->begin() + ind;
     }
 
-    void assign(std::initializer_list<T> il) {
-        this->assign(il.begin(), il.end());
-    }
+    void push_back(const value_type& value) { this->emplace_back(value); }
 
-    void assign(const size_t& n, const value_type& value) {
-        this->clear();
-        if (n > capacity_)
-            this->resize(n);
-        for (size_t i = 0; i < n; ++i)
-            this->push_back(value);
-    }
+    void push_back(value_type&& value) { this->emplace_back(std::move(value)); }
 
-    template<typename... Args>
-    iterator emplace(const_iterator p, Args&&... args) {
-        this->insert(p, value_type(std::forward<Args>(args)...));
+    template<typename ForwardIterator, typename = typename std::iterator_traits<ForwardIterator>::iterator_category>
+    void push_back(ForwardIterator first, ForwardIterator last) {
+        this->reserve_more(std::distance(first, last));
+        base::push_back(first, last);
     }
 
+    void push_back(const_pointer data, size_type n) { this->push_back(data, data + n); }
+
+    void push_front(const value_type& value) { this->emplace_front(value); }
+
+    void push_front(value_type&& value) { this->emplace_front(std::move(value)); }
+
     template<typename... Args>
     iterator emplace_back(Args&&... args) {
-        this->push_back(value_type(std::forward<Args>(args)...));
-    }
+        this->reserve_more(1);
 
-    reference operator[](size_type index) {
-        return *(this->begin() + index);
+        return base::emplace_back(std::forward<Args>(args)...);
     }
 
-    reference at(size_type index) {
-        return *(this->begin() + index);
+    template<typename... Args>
+    iterator emplace_front(Args&&... args) {
+        this->reserve_more(1);
+
+        return base::emplace_front(std::forward<Args>(args)...);
     }
 
-    bool operator==(const CCircularBufferExt<T>& other) const {
-        if (this->size_ != other.size_)
-            return false;
-        if (std::equal(this->cbegin(), this->cend(), other.cbegin(), other.cend()))
-            return true;
+    iterator insert(const_iterator p, const value_type& value) {
+        size_type ind = p - this->cbegin();
+        this->reserve_more(1);
 
-        return false;
+        return base::insert(this->cbegin() + ind, value);
     }
 
-    bool operator!=(const CCircularBufferExt<T>& other) const { return !(*this == other); }
+    iterator insert(const_iterator p, value_type&& value) {
+        size_type ind = p - this->cbegin();
+        this->reserve_more(1);
 
-    void swap(CCircularBufferExt<T, Allocator>& other) {
-        std::swap(start_, other.start_);
-        std::swap(readptr_, other.readptr_);
-        std::swap(writeptr_, other.writeptr_);
-        std::swap(size_, other.size_);
-        std::swap(capacity_, other.capacity_);
+        return base::insert(this->cbegin() + ind, std::move(value));
     }
 
-    size_type size() const { return size_; }
+    iterator insert(const_iterator p, const size_type& n, const value_type& value) {
+        size_type ind = p - this->cbegin();
+        this->reserve_more(n);
 
-    size_type capacity() const { return capacity_; }
+        return base::insert(this->cbegin() + ind, n, value);
+    }
 
-    size_type max_size() const { return alloc_.max_size(); }
+    template<typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category>
+    iterator insert(const_iterator p, InputIterator first, InputIterator last) {
+        size_type ind = p - this->cbegin();
+        this->reserve_more(std::distance(first, last));
 
-    bool full() const {return size_ == capacity_; }
+        return base::insert(this->cbegin() + ind, first, last);
+    }
 
-    bool empty() { return size_ == 0; }
+    iterator insert(const_iterator p, std::initializer_list<T> il) {
+        return this->insert(p, il.begin(), il.end());
+    }
 
-    size_type space_left() const { return capacity_ - size_; }
+    template<typename... Args>
+    iterator emplace(const_iterator p, Args&&... args) {
+        size_type ind = p - this->cbegin();
+        this->reserve_more(1);
 
-    void resize(const size_type newSize) {
-        if (newSize == capacity_)
-            return;
-        else if (newSize < capacity_) {
-            iterator first = this->begin();
-            iterator last = this->begin() + newSize - 1;
-            CCircularBufferExt<T> temp(first, last);
-            this->swap(temp);
-        } else {
-            CCircularBufferExt temp(newSize);
-            for (iterator it = this->begin(); it != this->end(); ++it)
-                temp.push_back(*it);
-            this->swap(temp);
-        }
+        return base::emplace(this->cbegin() + ind, std::forward<Args>(args)...);
     }
 };
 
-template<typename T>
-void swap(CCircularBufferExt<T>& a, CCircularBufferExt<T>& b) { a.swap(b); }
+template<typename T, typename Allocator, typename GrowthPolicy, typename ShrinkPolicy, typename StatsPolicy>
+void swap(CCircularBufferExt<T, Allocator, GrowthPolicy, ShrinkPolicy, StatsPolicy>& a,
+          CCircularBufferExt<T, Allocator, GrowthPolicy, ShrinkPolicy, StatsPolicy>& b) {
+    a.swap(b);
+}
+
+template<typename T, typename GrowthPolicy = CGeometricGrowth<kCapacityRate>, typename ShrinkPolicy = CNoShrink,
+         typename StatsPolicy = CNoStats>
+using CPmrCircularBufferExt =
+    CCircularBufferExt<T, std::pmr::polymorphic_allocator<T>, GrowthPolicy, ShrinkPolicy, StatsPolicy>;
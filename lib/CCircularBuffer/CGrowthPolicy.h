@@ -0,0 +1,66 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+
+// Growth policies decide the new capacity of a CCircularBufferExt that has to hold required elements.
+// next_capacity() is only called with required > capacity and must return at least required.
+
+// Multiplies the capacity by Factor, but grows by at least MinIncrement elements.
+template<size_t Factor, size_t MinIncrement = 1>
+struct CGeometricGrowth {
+    static_assert(Factor >= 1, "CGeometricGrowth can not shrink the buffer");
+
+    static size_t next_capacity(size_t capacity, size_t required) {
+        return std::max(std::max(capacity * Factor, capacity + MinIncrement), required);
+    }
+};
+
+// Same rule with the factor and the minimal increment chosen at runtime.
+struct CRuntimeGrowth {
+    double factor = 2;
+    size_t minIncrement = 1;
+
+    size_t next_capacity(size_t capacity, size_t required) const {
+        size_t scaled = static_cast<size_t>(static_cast<double>(capacity) * factor);
+
+        return std::max(std::max(scaled, capacity + minIncrement), required);
+    }
+};
+
+// Shrink policies decide whether a CCircularBufferExt that lost elements should move into smaller storage.
+// shrink_capacity() returns the capacity to shrink to, or capacity itself to keep the storage.
+
+// Never shrinks, the default.
+struct CNoShrink {
+    static size_t shrink_capacity(size_t capacity, size_t) { return capacity; }
+};
+
+// Shrinks once at most LowPercent of the capacity is used, to a capacity that is HighPercent full.
+// The gap between the two watermarks and the growth at 100% keeps the buffer from
+// growing and shrinking over and over around a single size.
+template<size_t LowPercent = 25, size_t HighPercent = 50, size_t MinCapacity = 16>
+struct CWatermarkShrink {
+    static_assert(LowPercent < HighPercent && HighPercent <= 100, "CWatermarkShrink needs LowPercent < HighPercent <= 100");
+
+    static size_t shrink_capacity(size_t capacity, size_t size) {
+        if (capacity <= MinCapacity || size * 100 > capacity * LowPercent)
+            return capacity;
+
+        return std::max(MinCapacity, (size * 100 + HighPercent - 1) / HighPercent);
+    }
+};
+
+// Same rule with the watermarks chosen at runtime, as fractions of the capacity.
+struct CRuntimeShrink {
+    double lowWatermark = 0.25;
+    double highWatermark = 0.5;
+    size_t minCapacity = 16;
+
+    size_t shrink_capacity(size_t capacity, size_t size) const {
+        if (capacity <= minCapacity || static_cast<double>(size) > static_cast<double>(capacity) * lowWatermark)
+            return capacity;
+        size_t target = static_cast<size_t>(static_cast<double>(size) / highWatermark);
+
+        return std::max(minCapacity, std::max(target, size));
+    }
+};
@@ -0,0 +1 @@
+#include "CHugePageAllocator.h"
@@ -0,0 +1,110 @@
+#pragma once
+#ifdef __linux__
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+const size_t kHugePageSize = 2 * 1024 * 1024;
+
+enum class ENumaPolicy {
+    kDefault,
+    kBind,
+    kInterleave,
+};
+
+// How CHugePageAllocator maps memory. Every step after mmap is best effort:
+// if the kernel refuses huge pages or a NUMA policy, the memory is still handed out.
+struct CHugePageOptions {
+    // Try MAP_HUGETLB first, which needs pages reserved in /proc/sys/vm/nr_hugepages.
+    bool hugeTlb = true;
+    // Otherwise ask for transparent huge pages with madvise(MADV_HUGEPAGE).
+    bool transparentHugePages = true;
+    // Touch every page in allocate(), so that no page fault happens later on the hot path.
+    bool prefault = true;
+    ENumaPolicy numaPolicy = ENumaPolicy::kDefault;
+    // Bit i selects NUMA node i for kBind and kInterleave.
+    unsigned long numaNodes = 0;
+
+    bool operator==(const CHugePageOptions& other) const {
+        return hugeTlb == other.hugeTlb && transparentHugePages == other.transparentHugePages &&
+               prefault == other.prefault && numaPolicy == other.numaPolicy && numaNodes == other.numaNodes;
+    }
+};
+
+// Linux-only allocator for large rings: anonymous mmap with huge pages, an optional NUMA policy
+// and prefaulting. Every allocation is its own mapping, so it is meant for a few big blocks.
+template<typename T>
+class CHugePageAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    CHugePageAllocator() = default;
+
+    explicit CHugePageAllocator(const CHugePageOptions& options) : options_(options) {}
+
+    template<typename U>
+    CHugePageAllocator(const CHugePageAllocator<U>& other) : options_(other.options()) {}
+
+    T* allocate(size_t n) {
+        size_t bytes = this->mapping_size(n);
+        void* area = MAP_FAILED;
+        if (options_.hugeTlb)
+            area = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (area == MAP_FAILED) {
+            area = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (area == MAP_FAILED)
+                throw std::bad_alloc();
+            if (options_.transparentHugePages)
+                madvise(area, bytes, MADV_HUGEPAGE);
+        }
+        if (options_.numaPolicy != ENumaPolicy::kDefault) {
+            int mode = options_.numaPolicy == ENumaPolicy::kBind ? MPOL_BIND : MPOL_INTERLEAVE;
+            syscall(SYS_mbind, area, bytes, mode, &options_.numaNodes, sizeof(options_.numaNodes) * 8 + 1, 0);
+        }
+        if (options_.prefault)
+            this->prefault(static_cast<char*>(area), bytes);
+
+        return static_cast<T*>(area);
+    }
+
+    void deallocate(T* p, size_t n) { munmap(p, this->mapping_size(n)); }
+
+    const CHugePageOptions& options() const { return options_; }
+
+    template<typename U>
+    bool operator==(const CHugePageAllocator<U>& other) const { return options_ == other.options(); }
+
+    template<typename U>
+    bool operator!=(const CHugePageAllocator<U>& other) const { return !(*this == other); }
+private:
+    CHugePageOptions options_;
+
+    // Huge page requests map whole huge pages, so the same n always gives the same mapping size.
+    size_t mapping_size(size_t n) const {
+        size_t unit = options_.hugeTlb || options_.transparentHugePages ? kHugePageSize : sysconf(_SC_PAGESIZE);
+
+        return (n * sizeof(T) + unit - 1) / unit * unit;
+    }
+
+    // Runs after mbind, so the pages are placed by the NUMA policy and not by the first touch.
+    static void prefault(char* area, size_t bytes) {
+#ifdef MADV_POPULATE_WRITE
+        if (madvise(area, bytes, MADV_POPULATE_WRITE) == 0)
+            return;
+#endif
+        size_t page = sysconf(_SC_PAGESIZE);
+        for (size_t i = 0; i < bytes; i += page)
+            static_cast<volatile char*>(area)[i] = 0;
+    }
+};
+
+#endif
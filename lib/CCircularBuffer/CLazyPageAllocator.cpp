@@ -0,0 +1 @@
+#include "CLazyPageAllocator.h"
@@ -0,0 +1,54 @@
+#pragma once
+#ifdef __linux__
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Linux-only allocator for huge, mostly empty rings. allocate() only reserves address space,
+// a page gets memory when the buffer first writes into it, and CCircularBuffer hands drained
+// pages back through decommit(), so resident memory follows the live elements and not the capacity.
+template<typename T>
+class CLazyPageAllocator {
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    CLazyPageAllocator() = default;
+
+    template<typename U>
+    CLazyPageAllocator(const CLazyPageAllocator<U>&) {}
+
+    // MAP_NORESERVE keeps the reservation out of the commit charge, the kernel backs a page on its first write.
+    T* allocate(size_t n) {
+        void* area = mmap(nullptr, mapping_size(n), PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (area == MAP_FAILED)
+            throw std::bad_alloc();
+
+        return static_cast<T*>(area);
+    }
+
+    void deallocate(T* p, size_t n) { munmap(p, mapping_size(n)); }
+
+    // Drops the memory behind whole pages, they read as zeros and get fresh memory on the next write.
+    void decommit(void* p, size_t bytes) { madvise(p, bytes, MADV_DONTNEED); }
+
+    static size_t page_size() {
+        static const size_t page = sysconf(_SC_PAGESIZE);
+        return page;
+    }
+
+    template<typename U>
+    bool operator==(const CLazyPageAllocator<U>&) const { return true; }
+
+    template<typename U>
+    bool operator!=(const CLazyPageAllocator<U>&) const { return false; }
+private:
+    static size_t mapping_size(size_t n) { return (n * sizeof(T) + page_size() - 1) / page_size() * page_size(); }
+};
+
+#endif
@@ -0,0 +1 @@
+#include "CMirroredCircularBuffer.h"
@@ -0,0 +1,212 @@
+#pragma once
+#ifdef __linux__
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Linux-only ring whose storage is one memfd mapped twice, back to back, so slot i and
+// slot i + capacity() are the same memory. Any run of up to capacity() elements starting
+// at front() is a single contiguous range and can be handed out without copying.
+// Elements live at two addresses at once, so only trivially copyable types are allowed.
+template<typename T>
+class CMirroredCircularBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "CMirroredCircularBuffer needs a trivially copyable type");
+private:
+    size_t capacity_;
+    size_t size_;
+    T* start_;
+    size_t readptr_;
+
+    size_t bytes() const { return capacity_ * sizeof(T); }
+
+    size_t wrap(size_t pos) const { return pos >= capacity_ ? pos - capacity_ : pos; }
+
+    // Smallest multiple of the page size that holds at least size elements and is divisible by sizeof(T).
+    static size_t round_up(size_t size) {
+        size_t page = sysconf(_SC_PAGESIZE);
+        size_t result = (size * sizeof(T) + page - 1) / page * page;
+        if (result == 0)
+            result = page;
+        while (result % sizeof(T) != 0)
+            result += page;
+
+        return result;
+    }
+
+    static T* map(size_t bytes) {
+        int fd = memfd_create("CMirroredCircularBuffer", MFD_CLOEXEC);
+        if (fd == -1)
+            throw std::bad_alloc();
+        if (ftruncate(fd, bytes) == -1) {
+            close(fd);
+            throw std::bad_alloc();
+        }
+        // Reserve both halves first so nothing else can be mapped in between.
+        void* area = mmap(nullptr, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (area == MAP_FAILED) {
+            close(fd);
+            throw std::bad_alloc();
+        }
+        char* base = static_cast<char*>(area);
+        bool mapped = mmap(base, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED
+            && mmap(base + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+        close(fd);
+        if (!mapped) {
+            munmap(area, 2 * bytes);
+            throw std::bad_alloc();
+        }
+
+        return reinterpret_cast<T*>(base);
+    }
+public:
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using array_range = std::pair<pointer, size_type>;
+    using const_array_range = std::pair<const_pointer, size_type>;
+
+    // The capacity is rounded up to whole pages, see capacity().
+    explicit CMirroredCircularBuffer(size_t size)
+        : capacity_(round_up(size) / sizeof(T)), size_(0), readptr_(0) {
+        start_ = map(this->bytes());
+    }
+
+    CMirroredCircularBuffer(const CMirroredCircularBuffer&) = delete;
+
+    CMirroredCircularBuffer& operator=(const CMirroredCircularBuffer&) = delete;
+
+    CMirroredCircularBuffer(CMirroredCircularBuffer&& other) noexcept
+        : capacity_(other.capacity_), size_(other.size_), start_(other.start_), readptr_(other.readptr_) {
+        other.capacity_ = 0;
+        other.size_ = 0;
+        other.start_ = nullptr;
+        other.readptr_ = 0;
+    }
+
+    CMirroredCircularBuffer& operator=(CMirroredCircularBuffer&& other) noexcept {
+        this->swap(other);
+
+        return *this;
+    }
+
+    ~CMirroredCircularBuffer() {
+        if (start_ != nullptr)
+            munmap(start_, 2 * this->bytes());
+    }
+
+    // Without free space the front element is overwritten, as in CCircularBuffer.
+    void push_back(const value_type& value) {
+        if (size_ == capacity_)
+            this->pop_front();
+        start_[readptr_ + size_] = value;
+        ++size_;
+    }
+
+    // Appends n elements with one copy, overwriting the oldest ones if they do not fit.
+    void push_back(const_pointer data, size_type n) {
+        if (n > capacity_) {
+            data += n - capacity_;
+            n = capacity_;
+        }
+        if (size_ + n > capacity_)
+            this->pop_front(size_ + n - capacity_);
+        std::memcpy(start_ + readptr_ + size_, data, n * sizeof(T));
+        size_ += n;
+    }
+
+    void pop_front() {
+        if (!this->empty()) {
+            readptr_ = this->wrap(readptr_ + 1);
+            --size_;
+        }
+    }
+
+    // Removes up to n elements from the front, returns how many were removed.
+    size_type pop_front(size_type n) {
+        n = std::min(n, size_);
+        readptr_ = this->wrap(readptr_ + n);
+        size_ -= n;
+
+        return n;
+    }
+
+    void pop_back() {
+        if (!this->empty())
+            --size_;
+    }
+
+    // All stored elements as one contiguous range, starting at front().
+    pointer data() { return start_ + readptr_; }
+
+    const_pointer data() const { return start_ + readptr_; }
+
+    // The first min(n, size()) elements as one contiguous range.
+    array_range span(size_type n) { return array_range(start_ + readptr_, std::min(n, size_)); }
+
+    const_array_range span(size_type n) const { return const_array_range(start_ + readptr_, std::min(n, size_)); }
+
+    // The free space after back() as one contiguous range. Fill it in place, then commit() what was written.
+    array_range free_span() { return array_range(start_ + readptr_ + size_, capacity_ - size_); }
+
+    // Publishes n elements written through free_span().
+    void commit(size_type n) { size_ += std::min(n, capacity_ - size_); }
+
+    iterator begin() { return start_ + readptr_; }
+
+    iterator end() { return start_ + readptr_ + size_; }
+
+    const_iterator begin() const { return start_ + readptr_; }
+
+    const_iterator end() const { return start_ + readptr_ + size_; }
+
+    const_iterator cbegin() const { return start_ + readptr_; }
+
+    const_iterator cend() const { return start_ + readptr_ + size_; }
+
+    reference front() { return start_[readptr_]; }
+
+    reference back() { return start_[readptr_ + size_ - 1]; }
+
+    reference operator[](size_type index) { return start_[readptr_ + index]; }
+
+    const_reference operator[](size_type index) const { return start_[readptr_ + index]; }
+
+    void clear() {
+        size_ = 0;
+        readptr_ = 0;
+    }
+
+    void swap(CMirroredCircularBuffer& other) noexcept {
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(start_, other.start_);
+        std::swap(readptr_, other.readptr_);
+    }
+
+    size_type size() const { return size_; }
+
+    size_type capacity() const { return capacity_; }
+
+    bool empty() const { return size_ == 0; }
+
+    bool full() const { return size_ == capacity_; }
+
+    size_type space_left() const { return capacity_ - size_; }
+};
+
+template<typename T>
+void swap(CMirroredCircularBuffer<T>& a, CMirroredCircularBuffer<T>& b) { a.swap(b); }
+
+#endif
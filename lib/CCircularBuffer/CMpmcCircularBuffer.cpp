@@ -0,0 +1 @@
+#include "CMpmcCircularBuffer.h"
@@ -0,0 +1,198 @@
+#pragma once
+#include "CCacheLine.h"
+#include "CCapacityPolicy.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Bounded lock-free queue for any number of producer and consumer threads.
+// Every slot carries a sequence number: a slot at position pos is free for the producer
+// when sequence == pos and holds a value for the consumer when sequence == pos + 1.
+// Positions are free-running counters, capacity is rounded to a power of two.
+// A claimed position can not be given back, so a producer whose value throws while being built
+// publishes the slot as skipped, and consumers release it without returning a value.
+template<typename T, typename Allocator = std::allocator<T>>
+class CMpmcCircularBuffer {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        // Set by a producer whose value threw, only read after the sequence says the slot is published.
+        bool skipped;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value() { return reinterpret_cast<T*>(storage); }
+    };
+
+    using cell_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Cell>;
+    using cell_traits = std::allocator_traits<cell_allocator>;
+
+    size_t capacity_;
+    Cell* cells_;
+    // Consumers and producers update these on every operation, each gets its own cache line.
+    alignas(kCacheLineSize) std::atomic<size_t> readptr_;
+    alignas(kCacheLineSize) std::atomic<size_t> writeptr_;
+    alignas(kCacheLineSize) cell_allocator alloc_;
+
+    Cell& cell(size_t pos) { return cells_[CPowerOfTwoCapacity::index(pos, capacity_)]; }
+
+    static intptr_t distance(size_t sequence, size_t pos) { return static_cast<intptr_t>(sequence - pos); }
+
+    // Claims up to n consecutive positions whose sequence is pos + lag, returns the first one.
+    size_t claim(std::atomic<size_t>& ptr, size_t lag, size_t& n) {
+        size_t pos = ptr.load(std::memory_order_relaxed);
+        for (;;) {
+            size_t ready = 0;
+            intptr_t dif = 0;
+            for (; ready < n; ++ready) {
+                dif = distance(cell(pos + ready).sequence.load(std::memory_order_acquire), pos + ready + lag);
+                if (dif != 0)
+                    break;
+            }
+            if (ready == 0 && dif < 0) {
+                n = 0;
+                return pos;
+            }
+            if (ready == 0) {
+                pos = ptr.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (ptr.compare_exchange_weak(pos, pos + ready, std::memory_order_relaxed)) {
+                n = ready;
+                return pos;
+            }
+        }
+    }
+
+    // Publishes the claimed positions [pos, end) without values after the value for pos threw.
+    void skip(size_t pos, size_t end) {
+        for (; pos != end; ++pos) {
+            Cell& slot = cell(pos);
+            slot.skipped = true;
+            slot.sequence.store(pos + 1, std::memory_order_release);
+        }
+    }
+
+    // Hands the slot at pos back to the producers, returns false if it held no value.
+    template<typename OutputIterator>
+    bool take(size_t pos, OutputIterator& out) {
+        Cell& slot = cell(pos);
+        bool full = !slot.skipped;
+        if (full) {
+            *out = std::move(*slot.value());
+            ++out;
+            slot.value()->~T();
+        }
+        slot.skipped = false;
+        slot.sequence.store(pos + capacity_, std::memory_order_release);
+
+        return full;
+    }
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using allocator_type = Allocator;
+
+    explicit CMpmcCircularBuffer(size_t size, const Allocator& alloc = Allocator())
+        : capacity_(CPowerOfTwoCapacity::round_up(size < 2 ? 2 : size)), readptr_(0), writeptr_(0), alloc_(alloc) {
+        cells_ = cell_traits::allocate(alloc_, capacity_);
+        for (size_t i = 0; i < capacity_; ++i) {
+            new (&cells_[i].sequence) std::atomic<size_t>(i);
+            cells_[i].skipped = false;
+        }
+    }
+
+    CMpmcCircularBuffer(const CMpmcCircularBuffer&) = delete;
+
+    CMpmcCircularBuffer& operator=(const CMpmcCircularBuffer&) = delete;
+
+    ~CMpmcCircularBuffer() {
+        size_t write = writeptr_.load(std::memory_order_relaxed);
+        for (size_t pos = readptr_.load(std::memory_order_relaxed); pos != write; ++pos)
+            if (!cell(pos).skipped)
+                cell(pos).value()->~T();
+        cell_traits::deallocate(alloc_, cells_, capacity_);
+    }
+
+    template<typename... Args>
+    bool try_emplace(Args&&... args) {
+        size_t n = 1;
+        size_t pos = this->claim(writeptr_, 0, n);
+        if (n == 0)
+            return false;
+        Cell& slot = cell(pos);
+        try {
+            new (slot.storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            this->skip(pos, pos + 1);
+            throw;
+        }
+        slot.sequence.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool try_enqueue(const value_type& value) { return this->try_emplace(value); }
+
+    bool try_enqueue(value_type&& value) { return this->try_emplace(std::move(value)); }
+
+    bool try_dequeue(value_type& value) {
+        for (;;) {
+            size_t n = 1;
+            size_t pos = this->claim(readptr_, 1, n);
+            if (n == 0)
+                return false;
+            value_type* out = &value;
+            if (this->take(pos, out))
+                return true;
+        }
+    }
+
+    // Enqueues up to n values from first with a single position claim, returns how many were taken.
+    // If a value throws, the values before it stay enqueued and the rest of the claim is skipped.
+    template<typename InputIterator>
+    size_type try_enqueue_bulk(InputIterator first, size_type n) {
+        size_t pos = this->claim(writeptr_, 0, n);
+        for (size_t i = 0; i < n; ++i, ++first) {
+            Cell& slot = cell(pos + i);
+            try {
+                new (slot.storage) T(*first);
+            } catch (...) {
+                this->skip(pos + i, pos + n);
+                throw;
+            }
+            slot.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+
+        return n;
+    }
+
+    // Dequeues up to n values into out with a single position claim, returns how many were written.
+    // Skipped slots are released on the way and do not count; a claim of only skipped slots is retried.
+    template<typename OutputIterator>
+    size_type try_dequeue_bulk(OutputIterator out, size_type n) {
+        for (;;) {
+            size_type claimed = n;
+            size_t pos = this->claim(readptr_, 1, claimed);
+            size_type done = 0;
+            for (size_t i = 0; i < claimed; ++i)
+                done += this->take(pos + i, out);
+            if (done != 0 || claimed == 0)
+                return done;
+        }
+    }
+
+    // Size as seen at the moment of the call, exact only when no thread is working on the queue.
+    size_type size() const {
+        size_t read = readptr_.load(std::memory_order_acquire);
+        size_t write = writeptr_.load(std::memory_order_acquire);
+
+        return write > read ? write - read : 0;
+    }
+
+    size_type capacity() const { return capacity_; }
+
+    bool empty() const { return this->size() == 0; }
+};
@@ -0,0 +1 @@
+#include "CPersistentCircularBuffer.h"
@@ -0,0 +1,307 @@
+#pragma once
+#ifdef __linux__
+#include "CCapacityPolicy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum class EDurability {
+    // Never calls msync, the kernel writes the pages back on its own. Survives a crash of the process.
+    kNone,
+    // Calls msync at most once per syncInterval, the clock is read on every 64th change.
+    kPeriodic,
+    // Every push_back() is on disk before the positions that make it visible are written.
+    kPerBatch,
+};
+
+struct CJournalOptions {
+    EDurability durability = EDurability::kNone;
+    std::chrono::milliseconds syncInterval = std::chrono::milliseconds(100);
+};
+
+// FNV-1a over whole 64-bit words, one multiplication per word keeps it cheap enough for every change.
+inline uint64_t JournalChecksum(const uint64_t* words, size_t n) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < n; ++i)
+        hash = (hash ^ words[i]) * 1099511628211ull;
+
+    return hash ^ (hash >> 29);
+}
+
+// Linux-only ring of trivially copyable elements kept in a memory-mapped file, so the last
+// capacity() elements survive a crash and are picked up again by the next process that opens the file.
+// The first page holds a checksummed header and two copies of the positions that are written
+// in turn, so a change torn by a crash leaves the previous one intact. Opening a file only
+// checks the header, the elements are never scanned.
+template<typename T>
+class CPersistentCircularBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "CPersistentCircularBuffer needs a trivially copyable type");
+private:
+    struct CPositions {
+        uint64_t readptr;
+        uint64_t writeptr;
+        uint64_t checksum;
+    };
+
+    struct CHeader {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t elementSize;
+        uint64_t capacity;
+        uint64_t checksum;
+        CPositions positions[2];
+    };
+
+    static constexpr uint64_t kMagic = 0x4c4e524a46425243;
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kPeriodicCheck = 64;
+
+    CJournalOptions options_;
+    size_t capacity_;
+    size_t pageSize_;
+    size_t mapSize_;
+    int fd_;
+    char* map_;
+    CHeader* header_;
+    T* start_;
+    // Free-running positions, the slot of position pos is pos & (capacity_ - 1).
+    uint64_t readptr_;
+    uint64_t writeptr_;
+    size_t slot_;
+    size_t changes_;
+    std::chrono::steady_clock::time_point lastSync_;
+
+    size_t index(uint64_t pos) const { return CPowerOfTwoCapacity::index(pos, capacity_); }
+
+    static uint64_t identity_checksum(const CHeader& header) {
+        uint64_t words[3] = {header.magic, uint64_t(header.version) << 32 | header.elementSize, header.capacity};
+
+        return JournalChecksum(words, 3);
+    }
+
+    static uint64_t positions_checksum(const CPositions& positions) {
+        uint64_t words[2] = {positions.readptr, positions.writeptr};
+
+        return JournalChecksum(words, 2);
+    }
+
+    bool consistent(const CPositions& positions) const {
+        return positions.checksum == positions_checksum(positions) && positions.readptr <= positions.writeptr &&
+               positions.writeptr - positions.readptr <= capacity_;
+    }
+
+    [[noreturn]] void fail(const std::string& what, int error) {
+        if (map_ != nullptr)
+            munmap(map_, mapSize_);
+        if (fd_ != -1)
+            close(fd_);
+        if (error != 0)
+            throw std::system_error(error, std::generic_category(), what);
+        throw std::runtime_error(what);
+    }
+
+    void create() {
+        header_->magic = kMagic;
+        header_->version = kVersion;
+        header_->elementSize = sizeof(T);
+        header_->capacity = capacity_;
+        header_->checksum = identity_checksum(*header_);
+        for (CPositions& positions : header_->positions) {
+            positions.readptr = 0;
+            positions.writeptr = 0;
+            positions.checksum = positions_checksum(positions);
+        }
+        msync(map_, pageSize_, MS_SYNC);
+    }
+
+    // Continues from the newest consistent copy of the positions, both only ever grow.
+    void recover(const std::string& path) {
+        if (header_->magic != kMagic || header_->version != kVersion || header_->elementSize != sizeof(T) ||
+            header_->capacity != capacity_ || header_->checksum != identity_checksum(*header_))
+            this->fail("journal header does not match: " + path, 0);
+        const CPositions& first = header_->positions[0];
+        const CPositions& second = header_->positions[1];
+        bool firstValid = this->consistent(first);
+        bool secondValid = this->consistent(second);
+        if (!firstValid && !secondValid)
+            this->fail("journal positions are corrupt: " + path, 0);
+        slot_ = !secondValid || (firstValid && first.writeptr >= second.writeptr && first.readptr >= second.readptr) ? 0 : 1;
+        readptr_ = header_->positions[slot_].readptr;
+        writeptr_ = header_->positions[slot_].writeptr;
+    }
+
+    // Writes the positions into the copy that was not written last.
+    void publish(uint64_t read, uint64_t write) {
+        std::atomic_signal_fence(std::memory_order_release);
+        slot_ ^= 1;
+        CPositions& positions = header_->positions[slot_];
+        positions.readptr = read;
+        positions.writeptr = write;
+        positions.checksum = positions_checksum(positions);
+        readptr_ = read;
+        writeptr_ = write;
+    }
+
+    // msync for the pages that hold bytes [begin, end) of the mapping.
+    void sync_bytes(size_t begin, size_t end) {
+        begin = begin / pageSize_ * pageSize_;
+        msync(map_ + begin, end - begin, MS_SYNC);
+    }
+
+    // Makes the n elements written at position pos visible, with the sync the durability asks for.
+    void commit(uint64_t pos, size_t n) {
+        if (options_.durability == EDurability::kPerBatch) {
+            size_t first = this->index(pos);
+            size_t head = std::min(n, capacity_ - first);
+            this->sync_bytes(pageSize_ + first * sizeof(T), pageSize_ + (first + head) * sizeof(T));
+            if (head != n)
+                this->sync_bytes(pageSize_, pageSize_ + (n - head) * sizeof(T));
+        }
+        this->publish(readptr_, pos + n);
+        this->changed();
+    }
+
+    // Moves the front to read before its slots are overwritten. With kPerBatch the header page
+    // reaches the file first, so a crash before the data sync never counts an overwritten slot as live.
+    void drop_front(uint64_t read) {
+        this->publish(read, writeptr_);
+        if (options_.durability == EDurability::kPerBatch)
+            this->sync_bytes(0, pageSize_);
+    }
+
+    void changed() {
+        if (options_.durability == EDurability::kPerBatch)
+            this->sync_bytes(0, pageSize_);
+        else if (options_.durability == EDurability::kPeriodic && ++changes_ % kPeriodicCheck == 0 &&
+                 std::chrono::steady_clock::now() - lastSync_ >= options_.syncInterval)
+            this->sync();
+    }
+public:
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using size_type = std::size_t;
+
+    // Opens the journal at path or creates it. An existing file must have been created with the same
+    // element size and capacity, otherwise std::runtime_error is thrown. The capacity is rounded up to a power of two.
+    CPersistentCircularBuffer(const std::string& path, size_t size, const CJournalOptions& options = CJournalOptions())
+        : options_(options), capacity_(CPowerOfTwoCapacity::round_up(size < 1 ? 1 : size)),
+          pageSize_(sysconf(_SC_PAGESIZE)), fd_(-1), map_(nullptr), slot_(0), changes_(0),
+          lastSync_(std::chrono::steady_clock::now()) {
+        static_assert(sizeof(CHeader) <= 4096, "the header must fit in one page");
+        mapSize_ = pageSize_ + (capacity_ * sizeof(T) + pageSize_ - 1) / pageSize_ * pageSize_;
+        fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ == -1)
+            this->fail("open " + path, errno);
+        struct stat info;
+        if (fstat(fd_, &info) == -1)
+            this->fail("fstat " + path, errno);
+        bool fresh = info.st_size == 0;
+        if (fresh && ftruncate(fd_, mapSize_) == -1)
+            this->fail("ftruncate " + path, errno);
+        if (!fresh && static_cast<size_t>(info.st_size) != mapSize_)
+            this->fail("journal size does not match: " + path, 0);
+        void* area = mmap(nullptr, mapSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (area == MAP_FAILED)
+            this->fail("mmap " + path, errno);
+        map_ = static_cast<char*>(area);
+        header_ = reinterpret_cast<CHeader*>(map_);
+        start_ = reinterpret_cast<T*>(map_ + pageSize_);
+        if (fresh)
+            this->create();
+        this->recover(path);
+    }
+
+    CPersistentCircularBuffer(const CPersistentCircularBuffer&) = delete;
+
+    CPersistentCircularBuffer& operator=(const CPersistentCircularBuffer&) = delete;
+
+    ~CPersistentCircularBuffer() {
+        if (options_.durability != EDurability::kNone)
+            this->sync();
+        munmap(map_, mapSize_);
+        close(fd_);
+    }
+
+    // Without free space the front element is overwritten, as in CCircularBuffer.
+    void push_back(const value_type& value) {
+        if (this->full())
+            this->drop_front(readptr_ + 1);
+        start_[this->index(writeptr_)] = value;
+        this->commit(writeptr_, 1);
+    }
+
+    // Appends n elements as one batch, overwriting the oldest ones if they do not fit.
+    void push_back(const_pointer data, size_type n) {
+        if (n > capacity_) {
+            data += n - capacity_;
+            n = capacity_;
+        }
+        if (this->size() + n > capacity_)
+            this->drop_front(writeptr_ + n - capacity_);
+        size_t first = this->index(writeptr_);
+        size_t head = std::min(n, capacity_ - first);
+        std::memcpy(start_ + first, data, head * sizeof(T));
+        std::memcpy(start_, data + head, (n - head) * sizeof(T));
+        this->commit(writeptr_, n);
+    }
+
+    void pop_front() {
+        if (!this->empty()) {
+            this->publish(readptr_ + 1, writeptr_);
+            this->changed();
+        }
+    }
+
+    // Removes up to n elements from the front, returns how many were removed.
+    size_type pop_front(size_type n) {
+        n = std::min(n, this->size());
+        this->publish(readptr_ + n, writeptr_);
+        this->changed();
+
+        return n;
+    }
+
+    void clear() { this->pop_front(this->size()); }
+
+    // Writes every change made so far to the file.
+    void sync() {
+        msync(map_, mapSize_, MS_SYNC);
+        lastSync_ = std::chrono::steady_clock::now();
+    }
+
+    reference front() { return start_[this->index(readptr_)]; }
+
+    reference back() { return start_[this->index(writeptr_ - 1)]; }
+
+    reference operator[](size_type index) { return start_[this->index(readptr_ + index)]; }
+
+    const_reference operator[](size_type index) const { return start_[this->index(readptr_ + index)]; }
+
+    const CJournalOptions& options() const { return options_; }
+
+    size_type size() const { return writeptr_ - readptr_; }
+
+    size_type capacity() const { return capacity_; }
+
+    bool empty() const { return readptr_ == writeptr_; }
+
+    bool full() const { return this->size() == capacity_; }
+};
+
+#endif
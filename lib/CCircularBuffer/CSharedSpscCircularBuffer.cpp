@@ -0,0 +1 @@
+#include "CSharedSpscCircularBuffer.h"
@@ -0,0 +1,198 @@
+#pragma once
+#ifdef __linux__
+#include "CCacheLine.h"
+#include "CCapacityPolicy.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Single-producer single-consumer ring in a POSIX shared-memory segment, for two processes on one host.
+// The segment holds only the header, the free-running positions and the elements; no pointers,
+// so every process may map it at a different address. One process is the producer and one the consumer,
+// each keeps its cached copy of the other side's position in its own handle.
+template<typename T>
+class CSharedSpscCircularBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "CSharedSpscCircularBuffer needs a trivially copyable type");
+    static_assert(alignof(T) <= kCacheLineSize, "CSharedSpscCircularBuffer can not align T");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "positions must be lock-free to be shared");
+private:
+    struct CSegment {
+        // magic is stored last by the creator, a segment without it is not initialised yet.
+        alignas(kCacheLineSize) std::atomic<uint64_t> magic;
+        uint32_t version;
+        uint32_t elementSize;
+        uint64_t capacity;
+        alignas(kCacheLineSize) std::atomic<uint64_t> writeptr;
+        alignas(kCacheLineSize) std::atomic<uint64_t> readptr;
+    };
+
+    static constexpr uint64_t kMagic = 0x43505353444d4853;
+    static constexpr uint32_t kVersion = 1;
+
+    std::string name_;
+    bool owner_;
+    size_t capacity_;
+    size_t mapSize_;
+    CSegment* segment_;
+    // Where this process mapped the elements, never stored in the segment.
+    T* start_;
+    alignas(kCacheLineSize) uint64_t cachedRead_;
+    alignas(kCacheLineSize) uint64_t cachedWrite_;
+
+    size_t index(uint64_t pos) const { return CPowerOfTwoCapacity::index(pos, capacity_); }
+
+    static size_t segment_size(size_t capacity) { return sizeof(CSegment) + capacity * sizeof(T); }
+
+    [[noreturn]] static void fail(const std::string& what, int error) {
+        if (error != 0)
+            throw std::system_error(error, std::generic_category(), what);
+        throw std::runtime_error(what);
+    }
+
+    void map(int fd) {
+        void* area = mmap(nullptr, mapSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        int error = errno;
+        close(fd);
+        if (area == MAP_FAILED) {
+            if (owner_)
+                shm_unlink(name_.c_str());
+            fail("mmap " + name_, error);
+        }
+        segment_ = static_cast<CSegment*>(area);
+        start_ = reinterpret_cast<T*>(static_cast<char*>(area) + sizeof(CSegment));
+    }
+public:
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+
+    // Creates the segment name, e.g. "/ring", which must not exist yet. The capacity is rounded up
+    // to a power of two. The creating handle removes the name again when it is destroyed.
+    CSharedSpscCircularBuffer(const std::string& name, size_t size)
+        : name_(name), owner_(true), capacity_(CPowerOfTwoCapacity::round_up(size < 2 ? 2 : size)),
+          mapSize_(segment_size(capacity_)), cachedRead_(0), cachedWrite_(0) {
+        int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd == -1)
+            fail("shm_open " + name_, errno);
+        if (ftruncate(fd, mapSize_) == -1) {
+            int error = errno;
+            close(fd);
+            shm_unlink(name_.c_str());
+            fail("ftruncate " + name_, error);
+        }
+        this->map(fd);
+        segment_->version = kVersion;
+        segment_->elementSize = sizeof(T);
+        segment_->capacity = capacity_;
+        segment_->writeptr.store(0, std::memory_order_relaxed);
+        segment_->readptr.store(0, std::memory_order_relaxed);
+        segment_->magic.store(kMagic, std::memory_order_release);
+    }
+
+    // Opens a segment made by the other constructor, in this or another process.
+    // Throws std::runtime_error if it is not initialised yet or was made for another version or element size.
+    explicit CSharedSpscCircularBuffer(const std::string& name)
+        : name_(name), owner_(false), capacity_(0), mapSize_(0) {
+        int fd = shm_open(name_.c_str(), O_RDWR | O_CLOEXEC, 0600);
+        if (fd == -1)
+            fail("shm_open " + name_, errno);
+        struct stat info;
+        if (fstat(fd, &info) == -1 || static_cast<size_t>(info.st_size) < sizeof(CSegment)) {
+            close(fd);
+            fail("shared ring is not initialised: " + name_, 0);
+        }
+        mapSize_ = info.st_size;
+        this->map(fd);
+        if (segment_->magic.load(std::memory_order_acquire) != kMagic || segment_->version != kVersion ||
+            segment_->elementSize != sizeof(T) || segment_size(segment_->capacity) != mapSize_) {
+            munmap(segment_, mapSize_);
+            fail("shared ring header does not match: " + name_, 0);
+        }
+        capacity_ = segment_->capacity;
+        cachedRead_ = segment_->readptr.load(std::memory_order_acquire);
+        cachedWrite_ = segment_->writeptr.load(std::memory_order_acquire);
+    }
+
+    CSharedSpscCircularBuffer(const CSharedSpscCircularBuffer&) = delete;
+
+    CSharedSpscCircularBuffer& operator=(const CSharedSpscCircularBuffer&) = delete;
+
+    ~CSharedSpscCircularBuffer() {
+        munmap(segment_, mapSize_);
+        if (owner_)
+            shm_unlink(name_.c_str());
+    }
+
+    // Producer side. Returns false instead of blocking when the ring is full.
+    template<typename... Args>
+    bool try_emplace(Args&&... args) {
+        uint64_t write = segment_->writeptr.load(std::memory_order_relaxed);
+        if (write - cachedRead_ == capacity_) {
+            cachedRead_ = segment_->readptr.load(std::memory_order_acquire);
+            if (write - cachedRead_ == capacity_)
+                return false;
+        }
+        new (start_ + index(write)) T(std::forward<Args>(args)...);
+        segment_->writeptr.store(write + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool try_push(const value_type& value) { return this->try_emplace(value); }
+
+    // Consumer side. Returns false instead of blocking when the ring is empty.
+    bool try_pop(value_type& value) {
+        uint64_t read = segment_->readptr.load(std::memory_order_relaxed);
+        if (read == cachedWrite_) {
+            cachedWrite_ = segment_->writeptr.load(std::memory_order_acquire);
+            if (read == cachedWrite_)
+                return false;
+        }
+        value = start_[index(read)];
+        segment_->readptr.store(read + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Consumer side. Returns the oldest element without removing it, nullptr if the ring is empty.
+    value_type* front() {
+        uint64_t read = segment_->readptr.load(std::memory_order_relaxed);
+        if (read == cachedWrite_) {
+            cachedWrite_ = segment_->writeptr.load(std::memory_order_acquire);
+            if (read == cachedWrite_)
+                return nullptr;
+        }
+
+        return start_ + index(read);
+    }
+
+    const std::string& name() const { return name_; }
+
+    // Size as seen at the moment of the call, exact only when both sides are idle.
+    size_type size() const {
+        uint64_t read = segment_->readptr.load(std::memory_order_acquire);
+
+        return segment_->writeptr.load(std::memory_order_acquire) - read;
+    }
+
+    size_type capacity() const { return capacity_; }
+
+    bool empty() const { return this->size() == 0; }
+
+    bool full() const { return this->size() == capacity_; }
+};
+
+#endif
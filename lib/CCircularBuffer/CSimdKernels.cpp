@@ -0,0 +1 @@
+#include "CSimdKernels.h"
@@ -0,0 +1,502 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+// Vectorized reductions and searches over the one or two contiguous segments of a ring, for arithmetic T.
+// Every kernel is written once with GCC vector extensions and compiled for SSE2, AVX2 and AVX-512
+// through target attributes; the widest level the CPU supports is picked at runtime.
+
+enum class ESimdLevel {
+    kScalar,
+    kSse2,
+    kAvx2,
+    kAvx512,
+};
+
+enum class ECompare {
+    kEqual,
+    kNotEqual,
+    kLess,
+    kLessEqual,
+    kGreater,
+    kGreaterEqual,
+};
+
+inline ESimdLevel DetectSimdLevel() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        return ESimdLevel::kAvx512;
+    if (__builtin_cpu_supports("avx2"))
+        return ESimdLevel::kAvx2;
+    if (__builtin_cpu_supports("sse2"))
+        return ESimdLevel::kSse2;
+#endif
+    return ESimdLevel::kScalar;
+}
+
+inline ESimdLevel& ActiveSimdLevel() {
+    static ESimdLevel level = DetectSimdLevel();
+
+    return level;
+}
+
+inline ESimdLevel SimdLevel() { return ActiveSimdLevel(); }
+
+// Caps the level the kernels use, e.g. to compare them. Levels the CPU lacks are never used,
+// returns the level that is active now.
+inline ESimdLevel SetSimdLevel(ESimdLevel level) {
+    return ActiveSimdLevel() = std::min(level, DetectSimdLevel());
+}
+
+template<typename T, size_t Width>
+struct CSimdVector {
+    typedef T type __attribute__((vector_size(Width), may_alias));
+};
+
+// Type the sums are accumulated in: integers add as unsigned, so an overflow wraps instead of being undefined.
+template<typename T, bool = std::is_integral_v<T>>
+struct CSumType {
+    using type = T;
+};
+
+template<typename T>
+struct CSumType<T, true> {
+    using type = std::make_unsigned_t<T>;
+};
+
+// Works on single values and on vectors, where every lane of the result is 0 or -1.
+// The result is an out parameter because vectors returned by value trip ABI warnings outside their target.
+template<ECompare Op, typename V, typename M>
+__attribute__((always_inline)) inline void CompareLanes(const V& a, const V& b, M& result) {
+    if constexpr (Op == ECompare::kEqual)
+        result = a == b;
+    else if constexpr (Op == ECompare::kNotEqual)
+        result = a != b;
+    else if constexpr (Op == ECompare::kLess)
+        result = a < b;
+    else if constexpr (Op == ECompare::kLessEqual)
+        result = a <= b;
+    else if constexpr (Op == ECompare::kGreater)
+        result = a > b;
+    else
+        result = a >= b;
+}
+
+template<ECompare Op, typename T>
+__attribute__((always_inline)) inline bool Matches(T a, T b) {
+    bool result;
+    CompareLanes<Op>(a, b, result);
+
+    return result;
+}
+
+template<typename M>
+__attribute__((always_inline)) inline bool AnyLane(const M& mask) {
+    using Words = typename CSimdVector<uint64_t, sizeof(M)>::type;
+    Words words = reinterpret_cast<const Words&>(mask);
+    uint64_t any = 0;
+    for (size_t i = 0; i < sizeof(M) / sizeof(uint64_t); ++i)
+        any |= words[i];
+
+    return any != 0;
+}
+
+// Elements before the first Width-aligned address, they are handled one by one
+// so that the vector loop only does aligned loads. Data not even aligned to sizeof(T)
+// never reaches a vector boundary and is handled one by one as a whole.
+template<size_t Width, typename T>
+__attribute__((always_inline)) inline size_t MisalignedHead(const T* data, size_t n) {
+    size_t misaligned = reinterpret_cast<uintptr_t>(data) % Width;
+    if (misaligned % sizeof(T) != 0)
+        return n;
+
+    return std::min(n, misaligned == 0 ? 0 : (Width - misaligned) / sizeof(T));
+}
+
+// Lanes are summed in their own order, so a floating-point result may differ from a sequential sum
+// in the last bits. Integers are summed as unsigned and wrap to T like a sum in unbounded precision.
+template<typename T, size_t Width>
+__attribute__((always_inline)) inline T SumKernel(const T* data, size_t n) {
+    using A = typename CSumType<T>::type;
+    using V = typename CSimdVector<A, Width>::type;
+    const size_t kLanes = Width / sizeof(T);
+    size_t head = MisalignedHead<Width>(data, n);
+    A sum = 0;
+    for (size_t i = 0; i < head; ++i)
+        sum += static_cast<A>(data[i]);
+    data += head;
+    n -= head;
+    const V* vectors = reinterpret_cast<const V*>(data);
+    size_t count = n / kLanes;
+    V acc[4] = {};
+    size_t v = 0;
+    for (; v + 4 <= count; v += 4) {
+        acc[0] += vectors[v];
+        acc[1] += vectors[v + 1];
+        acc[2] += vectors[v + 2];
+        acc[3] += vectors[v + 3];
+    }
+    for (; v < count; ++v)
+        acc[0] += vectors[v];
+    acc[0] += acc[1];
+    acc[2] += acc[3];
+    acc[0] += acc[2];
+    for (size_t i = 0; i < kLanes; ++i)
+        sum += acc[0][i];
+    for (size_t i = count * kLanes; i < n; ++i)
+        sum += static_cast<A>(data[i]);
+
+    return static_cast<T>(sum);
+}
+
+// Smallest (Op == kLess) or largest (Op == kGreater) of best and the n values.
+template<typename T, size_t Width, ECompare Op>
+__attribute__((always_inline)) inline T ExtremeKernel(const T* data, size_t n, T best) {
+    using V = typename CSimdVector<T, Width>::type;
+    using M = decltype(V() == V());
+    const size_t kLanes = Width / sizeof(T);
+    size_t head = MisalignedHead<Width>(data, n);
+    for (size_t i = 0; i < head; ++i)
+        best = Matches<Op>(data[i], best) ? data[i] : best;
+    data += head;
+    n -= head;
+    const V* vectors = reinterpret_cast<const V*>(data);
+    size_t count = n / kLanes;
+    V acc[2] = {V{} + best, V{} + best};
+    size_t v = 0;
+    M mask[2];
+    for (; v + 2 <= count; v += 2) {
+        CompareLanes<Op>(vectors[v], acc[0], mask[0]);
+        CompareLanes<Op>(vectors[v + 1], acc[1], mask[1]);
+        acc[0] = mask[0] ? vectors[v] : acc[0];
+        acc[1] = mask[1] ? vectors[v + 1] : acc[1];
+    }
+    for (; v < count; ++v) {
+        CompareLanes<Op>(vectors[v], acc[0], mask[0]);
+        acc[0] = mask[0] ? vectors[v] : acc[0];
+    }
+    CompareLanes<Op>(acc[1], acc[0], mask[0]);
+    acc[0] = mask[0] ? acc[1] : acc[0];
+    for (size_t i = 0; i < kLanes; ++i)
+        best = Matches<Op>(acc[0][i], best) ? acc[0][i] : best;
+    for (size_t i = count * kLanes; i < n; ++i)
+        best = Matches<Op>(data[i], best) ? data[i] : best;
+
+    return best;
+}
+
+// Counts values x with x Op value. The lanes count in the width of T and are flushed before they can overflow.
+template<typename T, size_t Width, ECompare Op>
+__attribute__((always_inline)) inline size_t CountKernel(const T* data, size_t n, T value) {
+    using V = typename CSimdVector<T, Width>::type;
+    using M = decltype(V() == V());
+    using Lane = std::decay_t<decltype(M()[0])>;
+    const size_t kLanes = Width / sizeof(T);
+    const size_t kBlock = std::min<size_t>(std::numeric_limits<Lane>::max(), 1 << 16);
+    size_t head = MisalignedHead<Width>(data, n);
+    size_t result = 0;
+    for (size_t i = 0; i < head; ++i)
+        result += Matches<Op>(data[i], value);
+    data += head;
+    n -= head;
+    const V* vectors = reinterpret_cast<const V*>(data);
+    size_t count = n / kLanes;
+    V needle = V{} + value;
+    for (size_t v = 0; v < count;) {
+        size_t end = std::min(count, v + kBlock);
+        M acc = {};
+        M mask;
+        for (; v < end; ++v) {
+            CompareLanes<Op>(vectors[v], needle, mask);
+            acc -= mask;
+        }
+        for (size_t i = 0; i < kLanes; ++i)
+            result += static_cast<size_t>(acc[i]);
+    }
+    for (size_t i = count * kLanes; i < n; ++i)
+        result += Matches<Op>(data[i], value);
+
+    return result;
+}
+
+// Index of the first x with x Op value, n if there is none. Tests four vectors at a time
+// and finds the exact position one by one.
+template<typename T, size_t Width, ECompare Op>
+__attribute__((always_inline)) inline size_t FindKernel(const T* data, size_t n, T value) {
+    using V = typename CSimdVector<T, Width>::type;
+    using M = decltype(V() == V());
+    const size_t kLanes = Width / sizeof(T);
+    size_t head = MisalignedHead<Width>(data, n);
+    for (size_t i = 0; i < head; ++i)
+        if (Matches<Op>(data[i], value))
+            return i;
+    const V* vectors = reinterpret_cast<const V*>(data + head);
+    size_t count = (n - head) / kLanes;
+    V needle = V{} + value;
+    M mask[4];
+    size_t v = 0;
+    for (; v + 4 <= count; v += 4) {
+        CompareLanes<Op>(vectors[v], needle, mask[0]);
+        CompareLanes<Op>(vectors[v + 1], needle, mask[1]);
+        CompareLanes<Op>(vectors[v + 2], needle, mask[2]);
+        CompareLanes<Op>(vectors[v + 3], needle, mask[3]);
+        mask[0] |= mask[1] | mask[2] | mask[3];
+        if (AnyLane(mask[0]))
+            break;
+    }
+    for (size_t i = head + v * kLanes; i < n; ++i)
+        if (Matches<Op>(data[i], value))
+            return i;
+
+    return n;
+}
+
+// The scalar versions also serve data that is not aligned to alignof(T), so they load through memcpy.
+template<typename T>
+__attribute__((always_inline)) inline T LoadValue(const T* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+
+    return value;
+}
+
+inline bool Unaligned(const void* data, size_t alignment) { return reinterpret_cast<uintptr_t>(data) % alignment != 0; }
+
+template<typename T>
+T ScalarSum(const T* data, size_t n) {
+    using A = typename CSumType<T>::type;
+    A sum = 0;
+    for (size_t i = 0; i < n; ++i)
+        sum += static_cast<A>(LoadValue(data + i));
+
+    return static_cast<T>(sum);
+}
+
+template<typename T, ECompare Op>
+T ScalarExtreme(const T* data, size_t n, T best) {
+    for (size_t i = 0; i < n; ++i) {
+        T value = LoadValue(data + i);
+        best = Matches<Op>(value, best) ? value : best;
+    }
+
+    return best;
+}
+
+template<typename T, ECompare Op>
+size_t ScalarCount(const T* data, size_t n, T value) {
+    size_t result = 0;
+    for (size_t i = 0; i < n; ++i)
+        result += Matches<Op>(LoadValue(data + i), value);
+
+    return result;
+}
+
+template<typename T, ECompare Op>
+size_t ScalarFind(const T* data, size_t n, T value) {
+    for (size_t i = 0; i < n; ++i)
+        if (Matches<Op>(LoadValue(data + i), value))
+            return i;
+
+    return n;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// One instantiation of every kernel per instruction set, the target attribute lets the compiler
+// use the wider registers without compiling the whole program for them.
+#define C_SIMD_KERNELS(Name, Target, Width)                                                              \
+    struct Name {                                                                                        \
+        template<typename T>                                                                             \
+        __attribute__((target(Target))) static T sum(const T* data, size_t n) {                          \
+            return SumKernel<T, Width>(data, n);                                                         \
+        }                                                                                                \
+        template<typename T, ECompare Op>                                                                \
+        __attribute__((target(Target))) static T extreme(const T* data, size_t n, T best) {              \
+            return ExtremeKernel<T, Width, Op>(data, n, best);                                           \
+        }                                                                                                \
+        template<typename T, ECompare Op>                                                                \
+        __attribute__((target(Target))) static size_t count(const T* data, size_t n, T value) {          \
+            return CountKernel<T, Width, Op>(data, n, value);                                            \
+        }                                                                                                \
+        template<typename T, ECompare Op>                                                                \
+        __attribute__((target(Target))) static size_t find(const T* data, size_t n, T value) {           \
+            return FindKernel<T, Width, Op>(data, n, value);                                             \
+        }                                                                                                \
+    };
+
+C_SIMD_KERNELS(CSse2Kernels, "sse2", 16)
+C_SIMD_KERNELS(CAvx2Kernels, "avx2", 32)
+C_SIMD_KERNELS(CAvx512Kernels, "avx512f,avx512bw", 64)
+
+#undef C_SIMD_KERNELS
+#endif
+
+template<typename T>
+T SimdSum(const T* data, size_t n) {
+    static_assert(std::is_arithmetic_v<T>, "SIMD kernels need an arithmetic type");
+#if defined(__x86_64__) || defined(__i386__)
+    switch (Unaligned(data, alignof(T)) ? ESimdLevel::kScalar : SimdLevel()) {
+        case ESimdLevel::kAvx512:
+            return CAvx512Kernels::sum(data, n);
+        case ESimdLevel::kAvx2:
+            return CAvx2Kernels::sum(data, n);
+        case ESimdLevel::kSse2:
+            return CSse2Kernels::sum(data, n);
+        default:
+            break;
+    }
+#endif
+    return ScalarSum(data, n);
+}
+
+template<typename T, ECompare Op>
+T SimdExtreme(const T* data, size_t n, T best) {
+    static_assert(std::is_arithmetic_v<T>, "SIMD kernels need an arithmetic type");
+#if defined(__x86_64__) || defined(__i386__)
+    switch (Unaligned(data, alignof(T)) ? ESimdLevel::kScalar : SimdLevel()) {
+        case ESimdLevel::kAvx512:
+            return CAvx512Kernels::extreme<T, Op>(data, n, best);
+        case ESimdLevel::kAvx2:
+            return CAvx2Kernels::extreme<T, Op>(data, n, best);
+        case ESimdLevel::kSse2:
+            return CSse2Kernels::extreme<T, Op>(data, n, best);
+        default:
+            break;
+    }
+#endif
+    return ScalarExtreme<T, Op>(data, n, best);
+}
+
+template<typename T, ECompare Op>
+size_t SimdCount(const T* data, size_t n, T value) {
+    static_assert(std::is_arithmetic_v<T>, "SIMD kernels need an arithmetic type");
+#if defined(__x86_64__) || defined(__i386__)
+    switch (Unaligned(data, alignof(T)) ? ESimdLevel::kScalar : SimdLevel()) {
+        case ESimdLevel::kAvx512:
+            return CAvx512Kernels::count<T, Op>(data, n, value);
+        case ESimdLevel::kAvx2:
+            return CAvx2Kernels::count<T, Op>(data, n, value);
+        case ESimdLevel::kSse2:
+            return CSse2Kernels::count<T, Op>(data, n, value);
+        default:
+            break;
+    }
+#endif
+    return ScalarCount<T, Op>(data, n, value);
+}
+
+template<typename T, ECompare Op>
+size_t SimdFind(const T* data, size_t n, T value) {
+    static_assert(std::is_arithmetic_v<T>, "SIMD kernels need an arithmetic type");
+#if defined(__x86_64__) || defined(__i386__)
+    switch (Unaligned(data, alignof(T)) ? ESimdLevel::kScalar : SimdLevel()) {
+        case ESimdLevel::kAvx512:
+            return CAvx512Kernels::find<T, Op>(data, n, value);
+        case ESimdLevel::kAvx2:
+            return CAvx2Kernels::find<T, Op>(data, n, value);
+        case ESimdLevel::kSse2:
+            return CSse2Kernels::find<T, Op>(data, n, value);
+        default:
+            break;
+    }
+#endif
+    return ScalarFind<T, Op>(data, n, value);
+}
+
+// The buffer-level functions take anything with const array_one() and array_two(),
+// e.g. CCircularBuffer, CCircularBufferExt and CStaticCircularBuffer.
+
+template<typename Buffer>
+typename Buffer::value_type SimdSum(const Buffer& buf) {
+    using T = typename Buffer::value_type;
+    using A = typename CSumType<T>::type;
+    auto one = buf.array_one();
+    auto two = buf.array_two();
+
+    return static_cast<T>(static_cast<A>(SimdSum(one.first, one.second)) + static_cast<A>(SimdSum(two.first, two.second)));
+}
+
+// The buffer must not be empty.
+template<typename Buffer>
+typename Buffer::value_type SimdMin(const Buffer& buf) {
+    using T = typename Buffer::value_type;
+    auto one = buf.array_one();
+    auto two = buf.array_two();
+    T best = SimdExtreme<T, ECompare::kLess>(one.first, one.second, *one.first);
+
+    return SimdExtreme<T, ECompare::kLess>(two.first, two.second, best);
+}
+
+// The buffer must not be empty.
+template<typename Buffer>
+typename Buffer::value_type SimdMax(const Buffer& buf) {
+    using T = typename Buffer::value_type;
+    auto one = buf.array_one();
+    auto two = buf.array_two();
+    T best = SimdExtreme<T, ECompare::kGreater>(one.first, one.second, *one.first);
+
+    return SimdExtreme<T, ECompare::kGreater>(two.first, two.second, best);
+}
+
+template<ECompare Op, typename Buffer>
+size_t SimdCount(const Buffer& buf, typename Buffer::value_type value) {
+    using T = typename Buffer::value_type;
+    auto one = buf.array_one();
+    auto two = buf.array_two();
+
+    return SimdCount<T, Op>(one.first, one.second, value) + SimdCount<T, Op>(two.first, two.second, value);
+}
+
+// Counts the elements x with x op value, e.g. SimdCount(buf, ECompare::kGreater, limit).
+template<typename Buffer>
+size_t SimdCount(const Buffer& buf, ECompare op, typename Buffer::value_type value) {
+    switch (op) {
+        case ECompare::kEqual:
+            return SimdCount<ECompare::kEqual>(buf, value);
+        case ECompare::kNotEqual:
+            return SimdCount<ECompare::kNotEqual>(buf, value);
+        case ECompare::kLess:
+            return SimdCount<ECompare::kLess>(buf, value);
+        case ECompare::kLessEqual:
+            return SimdCount<ECompare::kLessEqual>(buf, value);
+        case ECompare::kGreater:
+            return SimdCount<ECompare::kGreater>(buf, value);
+        default:
+            return SimdCount<ECompare::kGreaterEqual>(buf, value);
+    }
+}
+
+template<ECompare Op, typename Buffer>
+size_t SimdFind(const Buffer& buf, typename Buffer::value_type value) {
+    using T = typename Buffer::value_type;
+    auto one = buf.array_one();
+    size_t found = SimdFind<T, Op>(one.first, one.second, value);
+    if (found != one.second)
+        return found;
+    auto two = buf.array_two();
+
+    return one.second + SimdFind<T, Op>(two.first, two.second, value);
+}
+
+// Position of the first element x with x op value counted from front(), size() if there is none.
+template<typename Buffer>
+size_t SimdFind(const Buffer& buf, ECompare op, typename Buffer::value_type value) {
+    switch (op) {
+        case ECompare::kEqual:
+            return SimdFind<ECompare::kEqual>(buf, value);
+        case ECompare::kNotEqual:
+            return SimdFind<ECompare::kNotEqual>(buf, value);
+        case ECompare::kLess:
+            return SimdFind<ECompare::kLess>(buf, value);
+        case ECompare::kLessEqual:
+            return SimdFind<ECompare::kLessEqual>(buf, value);
+        case ECompare::kGreater:
+            return SimdFind<ECompare::kGreater>(buf, value);
+        default:
+            return SimdFind<ECompare::kGreaterEqual>(buf, value);
+    }
+}
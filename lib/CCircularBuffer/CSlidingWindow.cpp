@@ -0,0 +1 @@
+#include "CSlidingWindow.h"
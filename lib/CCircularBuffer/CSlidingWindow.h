@@ -0,0 +1,146 @@
+#pragma once
+#include "CCircularBuffer.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// Kahan-Babuska (Neumaier) summation, the error of every addition is kept in compensation_.
+class CCompensatedSum {
+public:
+    void add(double value) {
+        double sum = sum_ + value;
+        if (std::abs(sum_) >= std::abs(value))
+            compensation_ += (sum_ - sum) + value;
+        else
+            compensation_ += (value - sum) + sum_;
+        sum_ = sum;
+    }
+
+    double value() const { return sum_ + compensation_; }
+
+    void clear() {
+        sum_ = 0;
+        compensation_ = 0;
+    }
+private:
+    double sum_ = 0;
+    double compensation_ = 0;
+};
+
+// The last capacity() samples with their sum, mean, variance, min and max, each kept up to date
+// in O(1) amortized time by push_back(), including the overwrite of the oldest sample.
+// The sum and the sum of squared deviations are compensated, min and max come from monotonic
+// queues of (sequence number, sample) that never hold more than the window.
+template<typename T, typename Allocator = std::allocator<T>>
+class CSlidingWindow {
+    static_assert(std::is_arithmetic_v<T>, "CSlidingWindow needs an arithmetic type");
+private:
+    struct CEntry {
+        uint64_t sequence;
+        T value;
+    };
+
+    using entry_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<CEntry>;
+
+    CCircularBuffer<T, Allocator> window_;
+    CCircularBuffer<CEntry, entry_allocator> min_;
+    CCircularBuffer<CEntry, entry_allocator> max_;
+    CCompensatedSum sum_;
+    CCompensatedSum squares_;
+    // Sequence number of the next sample, the oldest sample in the window has pushed_ - size().
+    uint64_t pushed_ = 0;
+
+    template<typename Less>
+    static void enqueue(CCircularBuffer<CEntry, entry_allocator>& queue, uint64_t sequence, T value, Less less) {
+        while (!queue.empty() && !less(queue.back().value, value))
+            queue.pop_back();
+        queue.push_back(CEntry{sequence, value});
+    }
+
+    static void dequeue(CCircularBuffer<CEntry, entry_allocator>& queue, uint64_t sequence) {
+        if (!queue.empty() && queue.front().sequence == sequence)
+            queue.pop_front();
+    }
+
+    // Removes the oldest sample, squares_ gets Welford's update in reverse.
+    void evict() {
+        T value = window_.front();
+        double before = this->mean();
+        window_.pop_front();
+        if (window_.empty()) {
+            sum_.clear();
+            squares_.clear();
+        } else {
+            sum_.add(-static_cast<double>(value));
+            squares_.add(-(value - before) * (value - this->mean()));
+        }
+        uint64_t sequence = pushed_ - window_.size() - 1;
+        dequeue(min_, sequence);
+        dequeue(max_, sequence);
+    }
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    explicit CSlidingWindow(size_t size, const Allocator& alloc = Allocator())
+        : window_(size, alloc), min_(size, entry_allocator(alloc)), max_(size, entry_allocator(alloc)) {}
+
+    // Without free space the oldest sample is evicted first, as in CCircularBuffer.
+    void push_back(T value) {
+        if (window_.capacity() == 0)
+            return;
+        if (window_.full())
+            this->evict();
+        double before = this->mean();
+        window_.push_back(value);
+        sum_.add(value);
+        squares_.add((value - before) * (value - this->mean()));
+        enqueue(min_, pushed_, value, [](T a, T b) { return a < b; });
+        enqueue(max_, pushed_, value, [](T a, T b) { return b < a; });
+        ++pushed_;
+    }
+
+    // Removes the oldest sample.
+    void pop_front() {
+        if (!window_.empty())
+            this->evict();
+    }
+
+    void clear() {
+        window_.clear();
+        min_.clear();
+        max_.clear();
+        sum_.clear();
+        squares_.clear();
+    }
+
+    double sum() const { return sum_.value(); }
+
+    double mean() const { return window_.empty() ? 0 : sum_.value() / window_.size(); }
+
+    // Population variance of the window.
+    double variance() const {
+        if (window_.size() < 2)
+            return 0;
+        double squares = squares_.value();
+
+        return squares > 0 ? squares / window_.size() : 0;
+    }
+
+    // Smallest and largest sample, only valid for a non-empty window.
+    T min() const { return min_.front().value; }
+
+    T max() const { return max_.front().value; }
+
+    const CCircularBuffer<T, Allocator>& window() const { return window_; }
+
+    size_type size() const { return window_.size(); }
+
+    size_type capacity() const { return window_.capacity(); }
+
+    bool empty() const { return window_.empty(); }
+
+    bool full() const { return window_.full(); }
+};
@@ -0,0 +1 @@
+#include "CSpscCircularBuffer.h"
@@ -0,0 +1,132 @@
+#pragma once
+#include "CCacheLine.h"
+#include "CCapacityPolicy.h"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+// Lock-free ring for exactly one producer thread and one consumer thread.
+// writeptr is only stored by the producer and readptr only by the consumer,
+// both are free-running counters, so the buffer keeps no shared size counter.
+// Each side owns a cache line with its index and a cached copy of the other side's index,
+// and only reloads the other index when the cached one says the ring is full or empty.
+template<typename T, typename Allocator = std::allocator<T>>
+class CSpscCircularBuffer {
+    static_assert(alignof(T) <= kCacheLineSize, "CSpscCircularBuffer can not align T");
+private:
+    using alloc_traits = std::allocator_traits<Allocator>;
+    using line_allocator = typename alloc_traits::template rebind_alloc<CCacheLine>;
+    using line_traits = std::allocator_traits<line_allocator>;
+
+    struct alignas(kCacheLineSize) CProducer {
+        std::atomic<size_t> writeptr;
+        size_t cachedRead;
+    };
+
+    struct alignas(kCacheLineSize) CConsumer {
+        std::atomic<size_t> readptr;
+        size_t cachedWrite;
+    };
+
+    // Only read after construction, so this line is shared by both sides without bouncing.
+    size_t capacity_;
+    size_t lines_;
+    T* start_;
+    Allocator alloc_;
+
+    CProducer producer_;
+    CConsumer consumer_;
+
+    size_t index(size_t pos) const { return CPowerOfTwoCapacity::index(pos, capacity_); }
+public:
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+    using allocator_type = Allocator;
+
+    explicit CSpscCircularBuffer(size_t size, const Allocator& alloc = Allocator())
+        : capacity_(CPowerOfTwoCapacity::round_up(size)), alloc_(alloc) {
+        lines_ = (capacity_ * sizeof(T) + kCacheLineSize - 1) / kCacheLineSize;
+        line_allocator lines(alloc_);
+        start_ = reinterpret_cast<T*>(line_traits::allocate(lines, lines_));
+        producer_.writeptr.store(0, std::memory_order_relaxed);
+        producer_.cachedRead = 0;
+        consumer_.readptr.store(0, std::memory_order_relaxed);
+        consumer_.cachedWrite = 0;
+    }
+
+    CSpscCircularBuffer(const CSpscCircularBuffer&) = delete;
+
+    CSpscCircularBuffer& operator=(const CSpscCircularBuffer&) = delete;
+
+    ~CSpscCircularBuffer() {
+        size_t read = consumer_.readptr.load(std::memory_order_relaxed);
+        size_t write = producer_.writeptr.load(std::memory_order_relaxed);
+        for (; read != write; ++read)
+            alloc_traits::destroy(alloc_, start_ + index(read));
+        line_allocator lines(alloc_);
+        line_traits::deallocate(lines, reinterpret_cast<CCacheLine*>(start_), lines_);
+    }
+
+    // Producer side. Returns false instead of blocking when the ring is full.
+    template<typename... Args>
+    bool try_emplace(Args&&... args) {
+        size_t write = producer_.writeptr.load(std::memory_order_relaxed);
+        if (write - producer_.cachedRead == capacity_) {
+            producer_.cachedRead = consumer_.readptr.load(std::memory_order_acquire);
+            if (write - producer_.cachedRead == capacity_)
+                return false;
+        }
+        alloc_traits::construct(alloc_, start_ + index(write), std::forward<Args>(args)...);
+        producer_.writeptr.store(write + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool try_push(const value_type& value) { return this->try_emplace(value); }
+
+    bool try_push(value_type&& value) { return this->try_emplace(std::move(value)); }
+
+    // Consumer side. Returns false instead of blocking when the ring is empty.
+    bool try_pop(value_type& value) {
+        size_t read = consumer_.readptr.load(std::memory_order_relaxed);
+        if (read == consumer_.cachedWrite) {
+            consumer_.cachedWrite = producer_.writeptr.load(std::memory_order_acquire);
+            if (read == consumer_.cachedWrite)
+                return false;
+        }
+        T* slot = start_ + index(read);
+        value = std::move(*slot);
+        alloc_traits::destroy(alloc_, slot);
+        consumer_.readptr.store(read + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Consumer side. Returns the oldest element without removing it, nullptr if the ring is empty.
+    value_type* front() {
+        size_t read = consumer_.readptr.load(std::memory_order_relaxed);
+        if (read == consumer_.cachedWrite) {
+            consumer_.cachedWrite = producer_.writeptr.load(std::memory_order_acquire);
+            if (read == consumer_.cachedWrite)
+                return nullptr;
+        }
+
+        return start_ + index(read);
+    }
+
+    // Size as seen at the moment of the call, exact only when both sides are idle.
+    size_type size() const {
+        size_t read = consumer_.readptr.load(std::memory_order_acquire);
+
+        return producer_.writeptr.load(std::memory_order_acquire) - read;
+    }
+
+    size_type capacity() const { return capacity_; }
+
+    bool empty() const { return this->size() == 0; }
+
+    bool full() const { return this->size() == capacity_; }
+};
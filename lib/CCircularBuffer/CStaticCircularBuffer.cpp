@@ -0,0 +1 @@
+#include "CStaticCircularBuffer.h"
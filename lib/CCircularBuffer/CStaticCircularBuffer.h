@@ -0,0 +1,514 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Smallest unsigned type that can hold every value in [0, N].
+template<size_t N>
+using CStaticIndex = std::conditional_t<N <= UINT8_MAX, uint8_t,
+                     std::conditional_t<N <= UINT16_MAX, uint16_t,
+                     std::conditional_t<N <= UINT32_MAX, uint32_t, size_t>>>;
+
+// Circular buffer of at most N elements kept inline, without any heap allocation.
+// Has the container interface of CCircularBuffer except resize(), since the capacity is fixed.
+// N is a compile-time constant, so wrapping a position is a mask or a multiply instead of a division.
+template<typename T, size_t N>
+class CStaticCircularBuffer {
+    static_assert(N > 0, "CStaticCircularBuffer needs a positive capacity");
+private:
+    using index_type = CStaticIndex<N>;
+
+    alignas(T) unsigned char storage_[N * sizeof(T)];
+    index_type readptr_;
+    index_type size_;
+
+    static constexpr size_t wrap(size_t pos) { return pos % N; }
+
+    // Slot of the element at logical offset i from the front, only the first size_ of them are constructed.
+    T* slot(size_t i) { return reinterpret_cast<T*>(storage_) + wrap(readptr_ + i); }
+
+    const T* slot(size_t i) const { return reinterpret_cast<const T*>(storage_) + wrap(readptr_ + i); }
+
+    template<typename... Args>
+    void construct(size_t i, Args&&... args) { new (slot(i)) T(std::forward<Args>(args)...); }
+
+    void destroy_front(size_t n) {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t i = 0; i < n; ++i)
+                slot(i)->~T();
+        }
+        readptr_ = wrap(readptr_ + n);
+        size_ -= n;
+    }
+
+    void destroy_back(size_t n) {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t i = size_ - n; i < size_; ++i)
+                slot(i)->~T();
+        }
+        size_ -= n;
+    }
+
+    // Copies the whole storage at once when T allows it, otherwise copy-constructs every live element.
+    void copy_from(const CStaticCircularBuffer& other) {
+        if constexpr (std::is_trivially_copyable_v<T>)
+            std::memcpy(storage_, other.storage_, sizeof(storage_));
+        else {
+            for (size_t i = 0; i < other.size_; ++i)
+                new (reinterpret_cast<T*>(storage_) + wrap(other.readptr_ + i)) T(*other.slot(i));
+        }
+        readptr_ = other.readptr_;
+        size_ = other.size_;
+    }
+
+    void move_from(CStaticCircularBuffer& other) {
+        if constexpr (std::is_trivially_copyable_v<T>)
+            std::memcpy(storage_, other.storage_, sizeof(storage_));
+        else {
+            for (size_t i = 0; i < other.size_; ++i)
+                new (reinterpret_cast<T*>(storage_) + wrap(other.readptr_ + i)) T(std::move(*other.slot(i)));
+        }
+        readptr_ = other.readptr_;
+        size_ = other.size_;
+        other.clear();
+    }
+public:
+    using value_type = T;
+    using const_value_type = const T;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    // pointer to a contiguous part of the storage and the number of elements in it
+    using array_range = std::pair<pointer, size_type>;
+    using const_array_range = std::pair<const_pointer, size_type>;
+
+    // Iterates by logical offset from the front, so it stays valid across the wrap point.
+    // A reverse iterator at offset o refers to the element at o - 1, as in CCircularBuffer.
+    template<typename Tp, bool ReverseIterator = false>
+    class Iterator {
+    public:
+        using value_type = std::remove_const_t<Tp>;
+        using reference = Tp&;
+        using pointer = Tp*;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::random_access_iterator_tag;
+        using buffer_type = std::conditional_t<std::is_const_v<Tp>, const CStaticCircularBuffer, CStaticCircularBuffer>;
+
+        Iterator() : buffer_(nullptr), offset_(0) {}
+
+        Iterator(buffer_type* buffer, difference_type offset) : buffer_(buffer), offset_(offset) {}
+
+        reference operator*() const { return *this->slot(0); }
+
+        pointer operator->() const { return this->slot(0); }
+
+        reference operator[](difference_type n) const { return *this->slot(ReverseIterator ? -n : n); }
+
+        Iterator& operator++() {
+            offset_ += kStep;
+
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator temp = *this;
+            offset_ += kStep;
+
+            return temp;
+        }
+
+        Iterator& operator--() {
+            offset_ -= kStep;
+
+            return *this;
+        }
+
+        Iterator operator--(int) {
+            Iterator temp = *this;
+            offset_ -= kStep;
+
+            return temp;
+        }
+
+        Iterator& operator+=(difference_type n) {
+            offset_ += kStep * n;
+
+            return *this;
+        }
+
+        Iterator& operator-=(difference_type n) {
+            offset_ -= kStep * n;
+
+            return *this;
+        }
+
+        Iterator operator+(difference_type n) const { return Iterator(buffer_, offset_ + kStep * n); }
+
+        friend Iterator operator+(difference_type n, const Iterator& it) { return it + n; }
+
+        Iterator operator-(difference_type n) const { return Iterator(buffer_, offset_ - kStep * n); }
+
+        difference_type operator-(const Iterator& it) const { return kStep * (offset_ - it.offset_); }
+
+        operator Iterator<const Tp, ReverseIterator>() const { return Iterator<const Tp, ReverseIterator>(buffer_, offset_); }
+
+        bool operator==(const Iterator& other) const { return offset_ == other.offset_; }
+        bool operator!=(const Iterator& other) const { return offset_ != other.offset_; }
+        bool operator<(const Iterator& other) const { return *this - other < 0; }
+        bool operator>(const Iterator& other) const { return *this - other > 0; }
+        bool operator<=(const Iterator& other) const { return *this - other <= 0; }
+        bool operator>=(const Iterator& other) const { return *this - other >= 0; }
+    private:
+        static constexpr difference_type kStep = ReverseIterator ? -1 : 1;
+
+        buffer_type* buffer_;
+        difference_type offset_;
+
+        // The element n steps past the logical offset, counted from front().
+        pointer slot(difference_type n) const { return buffer_->slot(static_cast<size_type>(offset_ + n - ReverseIterator)); }
+    };
+
+    using iterator = Iterator<value_type>;
+    using const_iterator = Iterator<const_value_type>;
+    using reverse_iterator = Iterator<value_type, true>;
+    using const_reverse_iterator = Iterator<const_value_type, true>;
+
+    CStaticCircularBuffer() : readptr_(0), size_(0) {}
+
+    // Fills min(size, N) copies of sample, as CCircularBuffer(size, sample) does.
+    CStaticCircularBuffer(size_t size, const T& sample) : readptr_(0), size_(0) {
+        this->assign(size, sample);
+    }
+
+    template<typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category>
+    CStaticCircularBuffer(InputIterator first, InputIterator last) : readptr_(0), size_(0) {
+        this->push_back(first, last);
+    }
+
+    CStaticCircularBuffer(std::initializer_list<T> il) : readptr_(0), size_(0) {
+        this->push_back(il.begin(), il.end());
+    }
+
+    CStaticCircularBuffer(const CStaticCircularBuffer& other) { this->copy_from(other); }
+
+    CStaticCircularBuffer(CStaticCircularBuffer&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        this->move_from(other);
+    }
+
+    ~CStaticCircularBuffer() { this->clear(); }
+
+    CStaticCircularBuffer& operator=(const CStaticCircularBuffer& other) {
+        if (this != &other) {
+            this->clear();
+            this->copy_from(other);
+        }
+
+        return *this;
+    }
+
+    CStaticCircularBuffer& operator=(CStaticCircularBuffer&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if (this != &other) {
+            this->clear();
+            this->move_from(other);
+        }
+
+        return *this;
+    }
+
+    CStaticCircularBuffer& operator=(std::initializer_list<T> il) {
+        this->assign(il);
+
+        return *this;
+    }
+
+    iterator begin() { return iterator(this, 0); }
+
+    iterator end() { return iterator(this, size_); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+
+    const_iterator end() const { return const_iterator(this, size_); }
+
+    const_iterator cbegin() const { return const_iterator(this, 0); }
+
+    const_iterator cend() const { return const_iterator(this, size_); }
+
+    reverse_iterator rbegin() { return reverse_iterator(this, size_); }
+
+    reverse_iterator rend() { return reverse_iterator(this, 0); }
+
+    const_reverse_iterator crbegin() const { return const_reverse_iterator(this, size_); }
+
+    const_reverse_iterator crend() const { return const_reverse_iterator(this, 0); }
+
+    void push_back(const value_type& value) { this->emplace_back(value); }
+
+    void push_back(value_type&& value) { this->emplace_back(std::move(value)); }
+
+    void push_front(const value_type& value) { this->emplace_front(value); }
+
+    void push_front(value_type&& value) { this->emplace_front(std::move(value)); }
+
+    // A full buffer assigns over its oldest element after the new value is built, so args may refer to it.
+    template<typename... Args>
+    iterator emplace_back(Args&&... args) {
+        if (size_ == N) {
+            *slot(0) = value_type(std::forward<Args>(args)...);
+            readptr_ = wrap(readptr_ + 1);
+
+            return iterator(this, size_ - 1);
+        }
+        construct(size_, std::forward<Args>(args)...);
+        ++size_;
+
+        return iterator(this, size_ - 1);
+    }
+
+    // A full buffer assigns over its newest element instead.
+    template<typename... Args>
+    iterator emplace_front(Args&&... args) {
+        if (size_ == N) {
+            *slot(N - 1) = value_type(std::forward<Args>(args)...);
+            readptr_ = wrap(readptr_ + N - 1);
+
+            return this->begin();
+        }
+        new (reinterpret_cast<T*>(storage_) + wrap(readptr_ + N - 1)) T(std::forward<Args>(args)...);
+        readptr_ = wrap(readptr_ + N - 1);
+        ++size_;
+
+        return this->begin();
+    }
+
+    void pop_front() {
+        if (!empty())
+            destroy_front(1);
+    }
+
+    void pop_back() {
+        if (!empty())
+            destroy_back(1);
+    }
+
+    // Appends [first, last). When the range does not fit, the oldest elements are overwritten
+    // and only the last N values are kept.
+    template<typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category>
+    void push_back(InputIterator first, InputIterator last) {
+        for (; first != last; ++first)
+            this->emplace_back(*first);
+    }
+
+    void push_back(const_pointer data, size_type n) { this->push_back(data, data + n); }
+
+    // Removes up to n elements from the front, returns how many were removed.
+    size_type pop_front(size_type n) {
+        n = std::min<size_type>(n, size_);
+        destroy_front(n);
+
+        return n;
+    }
+
+    // Copies up to n elements from the front into out without removing them, returns how many were copied.
+    template<typename OutputIterator>
+    size_type copy_out(OutputIterator out, size_type n) const {
+        n = std::min<size_type>(n, size_);
+        std::copy_n(this->cbegin(), n, out);
+
+        return n;
+    }
+
+    // Moves up to n elements from the front into out, returns how many were read.
+    template<typename OutputIterator>
+    size_type read(OutputIterator out, size_type n) {
+        return this->pop_front(this->copy_out(out, n));
+    }
+
+    // The first contiguous part of the stored elements, starting at front().
+    array_range array_one() { return array_range(slot(0), std::min<size_type>(size_, N - readptr_)); }
+
+    // The wrapped part of the stored elements, starting at the beginning of the storage. Empty if nothing wraps.
+    array_range array_two() {
+        return array_range(reinterpret_cast<T*>(storage_), size_ - std::min<size_type>(size_, N - readptr_));
+    }
+
+    const_array_range array_one() const {
+        return const_array_range(slot(0), std::min<size_type>(size_, N - readptr_));
+    }
+
+    const_array_range array_two() const {
+        return const_array_range(reinterpret_cast<const T*>(storage_), size_ - std::min<size_type>(size_, N - readptr_));
+    }
+
+    reference front() { return *slot(0); }
+
+    const_reference front() const { return *slot(0); }
+
+    reference back() { return *slot(size_ - 1); }
+
+    const_reference back() const { return *slot(size_ - 1); }
+
+    void clear() {
+        destroy_front(size_);
+        readptr_ = 0;
+    }
+
+    // Same overwrite rules as CCircularBuffer::insert().
+    iterator insert(const_iterator p, const value_type& value) {
+        return this->insert_from(p - this->cbegin(), 1, [&value]() -> const value_type& { return value; });
+    }
+
+    iterator insert(const_iterator p, value_type&& value) {
+        return this->insert_from(p - this->cbegin(), 1, [&value]() -> value_type&& { return std::move(value); });
+    }
+
+    iterator insert(const_iterator p, const size_type& n, const value_type& value) {
+        return this->insert_from(p - this->cbegin(), n, [&value]() -> const value_type& { return value; });
+    }
+
+    template<typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category>
+    iterator insert(const_iterator p, InputIterator first, InputIterator last) {
+        size_type len = std::distance(first, last);
+
+        return this->insert_from(p - this->cbegin(), len, [&first]() -> decltype(auto) { return *first++; });
+    }
+
+    iterator insert(const_iterator p, std::initializer_list<T> il) {
+        return this->insert(p, il.begin(), il.end());
+    }
+
+    iterator erase(const_iterator p) {
+        if (p == this->cend())
+            return this->end();
+
+        return this->erase_n(p - this->cbegin(), 1);
+    }
+
+    iterator erase(const_iterator q1, const_iterator q2) {
+        return this->erase_n(q1 - this->cbegin(), q2 - q1);
+    }
+
+    template<typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category>
+    void assign(InputIterator first, InputIterator last) {
+        this->clear();
+        this->push_back(first, last);
+    }
+
+    void assign(std::initializer_list<T> il) {
+        this->assign(il.begin(), il.end());
+    }
+
+    void assign(const size_t& n, const value_type& value) {
+        this->clear();
+        for (size_t i = 0; i < std::min(n, N); ++i)
+            this->emplace_back(value);
+    }
+
+    template<typename... Args>
+    iterator emplace(const_iterator p, Args&&... args) {
+        if (p == this->cend() && !this->full())
+            return this->emplace_back(std::forward<Args>(args)...);
+
+        return this->insert(p, value_type(std::forward<Args>(args)...));
+    }
+
+    reference operator[](size_type index) { return *slot(index); }
+
+    const_reference operator[](size_type index) const { return *slot(index); }
+
+    reference at(size_type index) { return *slot(index); }
+
+    const_reference at(size_type index) const { return *slot(index); }
+
+    bool operator==(const CStaticCircularBuffer& other) const {
+        return size_ == other.size_ && std::equal(this->cbegin(), this->cend(), other.cbegin());
+    }
+
+    bool operator!=(const CStaticCircularBuffer& other) const { return !(*this == other); }
+
+    void swap(CStaticCircularBuffer& other) {
+        CStaticCircularBuffer temp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(temp);
+    }
+
+    size_type size() const { return size_; }
+
+    static constexpr size_type capacity() { return N; }
+
+    static constexpr size_type max_size() { return N; }
+
+    bool full() const { return size_ == N; }
+
+    bool empty() const { return size_ == 0; }
+
+    size_type space_left() const { return N - size_; }
+private:
+    // Inserts len values taken from next() before the element at offset, see CCircularBuffer::insert_from()
+    // for the overwrite rules. Elements are moved one by one on whichever side is shorter.
+    template<typename Source>
+    iterator insert_from(size_type offset, size_type len, Source&& next) {
+        size_type ins = std::min(len, offset + this->space_left());
+        size_type overwrite = len > this->space_left() ? std::min(offset, len - this->space_left()) : 0;
+        size_type grow = ins - overwrite;
+        size_type keep = offset - overwrite;
+        for (size_type i = ins; i < len; ++i)
+            next();
+        size_type oldSize = size_;
+        bool front = keep < size_ - offset;
+        if (grow != 0 && front) {
+            readptr_ = wrap(readptr_ + N - grow);
+            size_ += grow;
+            for (size_type i = 0; i < keep; ++i) {
+                if (i < grow)
+                    construct(i, std::move(*slot(i + grow)));
+                else
+                    *slot(i) = std::move(*slot(i + grow));
+            }
+        } else if (grow != 0) {
+            size_ += grow;
+            for (size_type i = oldSize; i > offset; --i) {
+                if (i - 1 + grow >= oldSize)
+                    construct(i - 1 + grow, std::move(*slot(i - 1)));
+                else
+                    *slot(i - 1 + grow) = std::move(*slot(i - 1));
+            }
+        }
+        for (size_type i = keep; i < offset + grow; ++i) {
+            if (front ? i < grow : i >= oldSize)
+                construct(i, next());
+            else
+                *slot(i) = next();
+        }
+
+        return iterator(this, keep);
+    }
+
+    // Closes the gap on whichever side has fewer elements to move.
+    iterator erase_n(size_type offset, size_type n) {
+        if (n == 0)
+            return iterator(this, offset);
+        size_type tail = size_ - offset - n;
+        if (offset < tail) {
+            for (size_type i = offset; i > 0; --i)
+                *slot(i - 1 + n) = std::move(*slot(i - 1));
+            destroy_front(n);
+        } else {
+            for (size_type i = offset + n; i < size_; ++i)
+                *slot(i - n) = std::move(*slot(i));
+            destroy_back(n);
+        }
+
+        return iterator(this, offset);
+    }
+};
+
+template<typename T, size_t N>
+void swap(CStaticCircularBuffer<T, N>& a, CStaticCircularBuffer<T, N>& b) { a.swap(b); }
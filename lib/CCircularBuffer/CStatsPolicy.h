@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// Counters of a buffer since its construction, as returned by stats().
+struct CBufferStats {
+    // Elements dropped to make room for a write into a full buffer.
+    size_t overwrites;
+    // Largest size() seen.
+    size_t highWater;
+    // Times the read or the write position crossed the end of the storage, in either direction.
+    size_t wraps;
+    // Capacity changes, including the growth and shrinking of CCircularBufferExt.
+    size_t resizes;
+    // Elements moved by insert() and erase() to open or close a gap.
+    size_t shifted;
+};
+
+// Statistics policies collect CBufferStats for a buffer. The buffer only computes a counter
+// when kEnabled is set, so the hooks of a disabled policy and their arguments compile to nothing.
+// Counters belong to the buffer object: copies, moves, assignments and swaps do not take them along.
+
+// Counts nothing and takes no space, the default.
+struct CNoStats {
+    static constexpr bool kEnabled = false;
+
+    static void add_overwrites(size_t) {}
+
+    static void add_wraps(size_t) {}
+
+    static void add_resize() {}
+
+    static void add_shifted(size_t) {}
+
+    static void record_size(size_t) {}
+
+    static CBufferStats snapshot() { return CBufferStats{}; }
+};
+
+// Relaxed atomic counters. Only the thread that owns the buffer updates them, with a plain load and store
+// instead of a locked read-modify-write; any other thread, e.g. a metrics exporter, may call snapshot().
+class CCountingStats {
+public:
+    static constexpr bool kEnabled = true;
+
+    CCountingStats() = default;
+
+    CCountingStats(const CCountingStats&) {}
+
+    CCountingStats& operator=(const CCountingStats&) { return *this; }
+
+    void add_overwrites(size_t n) { add(overwrites_, n); }
+
+    void add_wraps(size_t n) { add(wraps_, n); }
+
+    void add_resize() { add(resizes_, 1); }
+
+    void add_shifted(size_t n) { add(shifted_, n); }
+
+    void record_size(size_t size) {
+        if (size > highWater_.load(std::memory_order_relaxed))
+            highWater_.store(size, std::memory_order_relaxed);
+    }
+
+    // Each counter is read on its own, so a snapshot taken during an update may mix old and new values.
+    CBufferStats snapshot() const {
+        return CBufferStats{overwrites_.load(std::memory_order_relaxed), highWater_.load(std::memory_order_relaxed),
+                            wraps_.load(std::memory_order_relaxed), resizes_.load(std::memory_order_relaxed),
+                            shifted_.load(std::memory_order_relaxed)};
+    }
+private:
+    std::atomic<size_t> overwrites_{0};
+    std::atomic<size_t> highWater_{0};
+    std::atomic<size_t> wraps_{0};
+    std::atomic<size_t> resizes_{0};
+    std::atomic<size_t> shifted_{0};
+
+    static void add(std::atomic<size_t>& counter, size_t n) {
+        if (n != 0)
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
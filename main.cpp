@@ -1,5 +1,5 @@
-#include "lib\CCircularBuffer\CCircularBuffer.h"
-#include "lib\CCircularBuffer\CCircularBufferExt.h"
+#include "lib/CCircularBuffer/CCircularBuffer.h"
+#include "lib/CCircularBuffer/CCircularBufferExt.h"
 
 #include <iostream>
 
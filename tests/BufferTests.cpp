@@ -1,8 +1,148 @@
-#include "lib\CCircularBuffer\CCircularBuffer.h"
-#include "lib\CCircularBuffer\CCircularBufferExt.h"
+#include "lib/CCircularBuffer/CCircularBuffer.h"
+#include "lib/CCircularBuffer/CCircularBufferExt.h"
+#include "lib/CCircularBuffer/CStaticCircularBuffer.h"
+#include "lib/CCircularBuffer/CSlidingWindow.h"
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+// Counts how it gets constructed, the payload lives on the heap like std::string or std::vector.
+struct CTracked {
+    static size_t copies;
+    static size_t allocations;
+
+    std::unique_ptr<int32_t> payload;
+
+    explicit CTracked(int32_t value) : payload(new int32_t(value)) { ++allocations; }
+    CTracked(const CTracked& other) : payload(new int32_t(*other.payload)) { ++copies; ++allocations; }
+    CTracked(CTracked&& other) noexcept = default;
+    CTracked& operator=(const CTracked& other) {
+        payload.reset(new int32_t(*other.payload));
+        ++copies;
+        ++allocations;
+        return *this;
+    }
+    CTracked& operator=(CTracked&& other) noexcept = default;
+
+    static void reset() {
+        copies = 0;
+        allocations = 0;
+    }
+};
+
+size_t CTracked::copies = 0;
+size_t CTracked::allocations = 0;
+
+// Counts objects that are constructed and not yet destroyed.
+struct CLive {
+    static int64_t alive;
+
+    int32_t value;
+
+    CLive(int32_t v) : value(v) { ++alive; }
+    CLive(const CLive& other) : value(other.value) { ++alive; }
+    CLive& operator=(const CLive& other) = default;
+    ~CLive() { --alive; }
+
+    bool operator==(const CLive& other) const { return value == other.value; }
+};
+
+int64_t CLive::alive = 0;
+
+// Stateful allocator, two instances are equal only with the same id. Propagate picks all propagate_on_* traits.
+template<typename T, bool Propagate>
+struct CTaggedAllocator {
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::bool_constant<Propagate>;
+    using propagate_on_container_move_assignment = std::bool_constant<Propagate>;
+    using propagate_on_container_swap = std::bool_constant<Propagate>;
+    using is_always_equal = std::false_type;
+
+    int32_t id;
+
+    CTaggedAllocator(int32_t id = 0) : id(id) {}
+
+    template<typename U>
+    CTaggedAllocator(const CTaggedAllocator<U, Propagate>& other) : id(other.id) {}
+
+    T* allocate(size_t n) { return std::allocator<T>().allocate(n); }
+
+    void deallocate(T* p, size_t n) { std::allocator<T>().deallocate(p, n); }
+
+    CTaggedAllocator select_on_container_copy_construction() const { return CTaggedAllocator(id + 100); }
+
+    bool operator==(const CTaggedAllocator& other) const { return id == other.id; }
+
+    bool operator!=(const CTaggedAllocator& other) const { return id != other.id; }
+};
+
+// Runs random inserts and erases at both ends and in the middle against a std::deque model.
+template<typename Buffer, typename Make>
+void CompareWithDeque(Buffer& buf, Make make) {
+    using value_type = typename Buffer::value_type;
+    std::mt19937 gen(42);
+    std::deque<value_type> model;
+    for (int32_t step = 0; step < 2000; ++step) {
+        size_t offset = model.empty() ? 0 : gen() % (model.size() + 1);
+        size_t n = 1 + gen() % 3;
+        if (gen() % 2 == 0 || model.empty()) {
+            std::vector<value_type> values;
+            for (size_t i = 0; i < n; ++i)
+                values.push_back(make(step * 3 + i));
+            buf.insert(buf.cbegin() + offset, values.begin(), values.end());
+            size_t space = buf.capacity() - model.size();
+            size_t ins = std::min(n, offset + space);
+            size_t overwrite = n > space ? std::min(offset, n - space) : 0;
+            model.erase(model.begin() + (offset - overwrite), model.begin() + offset);
+            model.insert(model.begin() + (offset - overwrite), values.begin() + (n - ins), values.end());
+        } else {
+            n = std::min(n, model.size() - std::min(offset, model.size() - 1));
+            offset = std::min(offset, model.size() - n);
+            buf.erase(buf.cbegin() + offset, buf.cbegin() + (offset + n));
+            model.erase(model.begin() + offset, model.begin() + (offset + n));
+        }
+        ASSERT_EQ(buf.size(), model.size());
+        ASSERT_TRUE(std::equal(model.begin(), model.end(), buf.begin()));
+    }
+}
+
+// Written once against the container interface, so it runs unchanged on every ring of capacity 8.
+template<typename Buffer>
+void CheckWrappedIterators(Buffer& buf) {
+    for (int i = 0; i < 13; ++i)
+        buf.push_back(i);
+    buf.pop_back();
+    typename Buffer::iterator first = buf.begin();
+    ASSERT_EQ(buf.end() - first, 7);
+    ASSERT_EQ(*(4 + first), 9);
+    ASSERT_EQ(*(first + 4), 9);
+    typename Buffer::const_iterator cfirst = first;
+    ASSERT_EQ(buf.cend() - cfirst, 7);
+    typename Buffer::reverse_iterator rit = buf.rbegin();
+    ASSERT_EQ(*rit, 11);
+    ASSERT_EQ(*(2 + rit), 9);
+    ASSERT_EQ(rit[6], 5);
+    ASSERT_EQ(buf.rend() - rit, 7);
+    typename Buffer::const_reverse_iterator crit = rit;
+    ASSERT_TRUE(crit < buf.crend());
+    std::sort(buf.rbegin(), buf.rend());
+    ASSERT_EQ(std::vector<int>(buf.begin(), buf.end()), std::vector<int>({11, 10, 9, 8, 7, 6, 5}));
+    ASSERT_EQ(std::vector<int>(buf.crbegin(), buf.crend()), std::vector<int>({5, 6, 7, 8, 9, 10, 11}));
+}
+
+}
+
 TEST(BufferTestSuite, CreationTest1) {
     CCircularBuffer<uint32_t> buf(6);
     ASSERT_EQ(buf.capacity(), 6);
@@ -97,6 +237,67 @@ TEST (BufferTestSuite, IndexTest) {
     ASSERT_EQ(buf.at(7), 'D');
 }
 
+TEST(BufferTestSuite, IteratorArithmeticTest) {
+    CCircularBuffer<int> buf(8);
+    for (int i = 0; i < 13; ++i)
+        buf.push_back(i);
+    buf.pop_back();
+    // The front is at slot 5: 5..7 sit in slots 5..7 and 8..11 wrap around to slots 0..3.
+    auto first = buf.begin();
+    auto last = buf.end();
+    ASSERT_EQ(last - first, 7);
+    ASSERT_EQ(first[6], 11);
+    ASSERT_EQ(*(first + 4), 9);
+    ASSERT_EQ(*(4 + first), 9);
+    ASSERT_EQ(*(last - 1), 11);
+    ASSERT_TRUE(first < last && last > first && first <= first && last >= first);
+    auto it = first;
+    it += 5;
+    it -= 2;
+    ASSERT_EQ(*it, 8);
+    ASSERT_EQ(it - first, 3);
+    ASSERT_EQ(first - it, -3);
+    CCircularBuffer<int>::const_iterator cit = it;
+    ASSERT_EQ(cit - buf.cbegin(), 3);
+    ASSERT_EQ(std::distance(buf.cbegin(), buf.cend()), 7);
+
+    auto rit = buf.rbegin();
+    ASSERT_EQ(*rit, 11);
+    ASSERT_EQ(rit[2], 9);
+    ASSERT_EQ(buf.rend() - rit, 7);
+    ASSERT_EQ(*(buf.rend() - 1), 5);
+    ASSERT_TRUE(rit < buf.rend());
+    std::vector<int> reversed(buf.crbegin(), buf.crend());
+    ASSERT_EQ(reversed, (std::vector<int>{11, 10, 9, 8, 7, 6, 5}));
+
+    const CCircularBuffer<int>& view = buf;
+    int sum = 0;
+    for (int value : view)
+        sum += value;
+    ASSERT_EQ(sum, 56);
+    ASSERT_EQ(view[6], 11);
+    ASSERT_EQ(view.at(0), 5);
+}
+
+TEST(BufferTestSuite, IteratorAlgorithmsTest) {
+    CCircularBuffer<int> buf(100);
+    std::mt19937 gen(3);
+    for (int i = 0; i < 170; ++i)
+        buf.push_back(static_cast<int>(gen() % 1000));
+    std::vector<int> expected(buf.begin(), buf.end());
+    std::sort(buf.begin(), buf.end());
+    std::sort(expected.begin(), expected.end());
+    ASSERT_TRUE(std::equal(buf.begin(), buf.end(), expected.begin(), expected.end()));
+    for (int value : {-1, 0, 500, 999, 1000}) {
+        ASSERT_EQ(std::lower_bound(buf.cbegin(), buf.cend(), value) - buf.cbegin(),
+                  std::lower_bound(expected.begin(), expected.end(), value) - expected.begin());
+    }
+    std::sort(buf.rbegin(), buf.rend());
+    ASSERT_TRUE(std::is_sorted(buf.begin(), buf.end(), std::greater<int>()));
+    std::reverse(buf.begin(), buf.end());
+    ASSERT_TRUE(std::is_sorted(buf.begin(), buf.end()));
+}
+
 TEST (BufferTestSuite, AssignTest) {
     CCircularBuffer<int32_t> buf1({3, 4, 5, 6, 7});
     CCircularBuffer<int32_t> buf2({4, 4, 4, 4});
@@ -109,6 +310,36 @@ TEST (BufferTestSuite, AssignTest) {
     ASSERT_EQ(buf1.size(), 6);
 }
 
+TEST (BufferTestSuite, AssignEmptyTest) {
+    CCircularBuffer<int32_t> buf1;
+    CCircularBuffer<int32_t> buf2;
+    std::vector<int32_t> empty;
+    buf1 = buf2;
+    buf1 = {};
+    buf1.assign(empty.begin(), empty.end());
+    ASSERT_TRUE(buf1.empty());
+    ASSERT_EQ(buf1.capacity(), 0);
+    CCircularBuffer<int32_t> buf3(buf2);
+    ASSERT_EQ(buf3, buf2);
+    CCircularBufferExt<int32_t> ext;
+    ext.push_back(empty.begin(), empty.end());
+    ASSERT_TRUE(ext.empty());
+    ext.push_back(empty.data(), 0);
+    ext = CCircularBufferExt<int32_t>();
+    ASSERT_TRUE(ext.empty());
+}
+
+TEST (BufferTestSuite, PushAliasTest) {
+    CCircularBuffer<std::string> buf(3);
+    for (const char* value : {"first string longer than sso", "second string longer than sso", "third"})
+        buf.push_back(value);
+    buf.push_back(buf.front());
+    buf.push_front(buf.back());
+    buf.emplace_back(buf.front());
+    ASSERT_EQ(std::vector<std::string>(buf.begin(), buf.end()),
+              std::vector<std::string>({"second string longer than sso", "third", "first string longer than sso"}));
+}
+
 TEST (BufferTestSuite, FrontBackTest) {
     CCircularBuffer<int32_t> buf1({3, 4, 5, 6, 7});
     ASSERT_EQ(buf1.back(), 7);
@@ -122,6 +353,192 @@ TEST (BufferTestSuite, SwapTest) {
     ASSERT_EQ(buf2, CCircularBuffer<int32_t>({3, 4, 5, 6, 7}));
 }
 
+TEST (BufferTestSuite, PowerOfTwoCapacityTest) {
+    CCircularBuffer<uint32_t, std::allocator<uint32_t>, CPowerOfTwoCapacity> buf(5);
+    ASSERT_EQ(buf.capacity(), 8);
+    for (uint32_t i = 0; i < 20; ++i)
+        buf.push_back(i);
+    ASSERT_EQ(buf.size(), 8);
+    ASSERT_EQ(buf.front(), 12);
+    ASSERT_EQ(buf.back(), 19);
+    ASSERT_EQ(buf[3], 15);
+    buf.pop_front();
+    buf.push_front(100);
+    ASSERT_EQ(buf.front(), 100);
+    ASSERT_EQ(*(buf.begin() + 11), 15);
+    ASSERT_EQ(buf.end() - buf.begin(), 8);
+}
+
+TEST (BufferTestSuite, PowerOfTwoCapacityEqualsModuloTest) {
+    CCircularBuffer<int32_t, std::allocator<int32_t>, CPowerOfTwoCapacity> buf1(4);
+    CCircularBuffer<int32_t> buf2(4);
+    for (int32_t i = 0; i < 11; ++i) {
+        buf1.push_back(i);
+        buf2.push_back(i);
+        if (i % 3 == 0) {
+            buf1.pop_front();
+            buf2.pop_front();
+        }
+    }
+    ASSERT_EQ(buf1.size(), buf2.size());
+    ASSERT_TRUE(std::equal(buf1.begin(), buf1.end(), buf2.begin()));
+}
+
+TEST (BufferTestSuite, ArrayRangeTest) {
+    CCircularBuffer<int32_t> buf({1, 2, 3, 4, 5});
+    ASSERT_EQ(buf.array_one().second, 5);
+    ASSERT_EQ(buf.array_two().second, 0);
+    buf.push_back(6);
+    buf.push_back(7);
+    ASSERT_EQ(buf.array_one().second, 3);
+    ASSERT_EQ(buf.array_one().first[0], 3);
+    ASSERT_EQ(buf.array_two().second, 2);
+    ASSERT_EQ(buf.array_two().first[1], 7);
+}
+
+TEST (BufferTestSuite, BulkPushTest) {
+    CCircularBuffer<int32_t> buf(5);
+    int32_t data[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    buf.push_back(data, 3);
+    ASSERT_EQ(buf, CCircularBuffer<int32_t>({1, 2, 3}));
+    buf.push_back(data + 3, data + 6);
+    ASSERT_EQ(buf, CCircularBuffer<int32_t>({2, 3, 4, 5, 6}));
+    buf.push_back(data, data + 8);
+    ASSERT_EQ(buf, CCircularBuffer<int32_t>({4, 5, 6, 7, 8}));
+    std::vector<int32_t> values = {9, 10};
+    buf.push_back(values.begin(), values.end());
+    ASSERT_EQ(buf, CCircularBuffer<int32_t>({6, 7, 8, 9, 10}));
+}
+
+TEST (BufferTestSuite, BulkPopReadTest) {
+    CCircularBuffer<int32_t> buf(4);
+    int32_t data[] = {1, 2, 3, 4, 5, 6};
+    buf.push_back(data, data + 6);
+    int32_t out[6] = {};
+    ASSERT_EQ(buf.copy_out(out, 3), 3);
+    ASSERT_EQ(out[0], 3);
+    ASSERT_EQ(out[2], 5);
+    ASSERT_EQ(buf.size(), 4);
+    ASSERT_EQ(buf.pop_front(1), 1);
+    ASSERT_EQ(buf.read(out, 10), 3);
+    ASSERT_EQ(out[0], 4);
+    ASSERT_EQ(out[2], 6);
+    ASSERT_TRUE(buf.empty());
+    ASSERT_EQ(buf.pop_front(2), 0);
+}
+
+TEST (BufferTestSuite, MoveTest) {
+    CCircularBuffer<std::string> buf(3);
+    buf.push_back(std::string(100, 'a'));
+    buf.push_back("b");
+    const char* data = buf.front().data();
+    CCircularBuffer<std::string> moved(std::move(buf));
+    ASSERT_EQ(moved.size(), 2);
+    ASSERT_EQ(moved.front().data(), data);
+    ASSERT_EQ(buf.size(), 0);
+    CCircularBuffer<std::string> assigned(1);
+    assigned = std::move(moved);
+    ASSERT_EQ(assigned.capacity(), 3);
+    ASSERT_EQ(assigned.back(), "b");
+    CCircularBuffer<std::string> copy(assigned);
+    ASSERT_EQ(copy, assigned);
+}
+
+TEST (BufferTestSuite, EmplaceTest) {
+    CCircularBuffer<std::string> buf(3);
+    ASSERT_EQ(*buf.emplace_back(3, 'x'), "xxx");
+    ASSERT_EQ(*buf.emplace_front("front"), "front");
+    ASSERT_EQ(*buf.emplace(buf.cbegin() + 1, 2, 'y'), "yy");
+    ASSERT_EQ(buf, CCircularBuffer<std::string>({"front", "yy", "xxx"}));
+    buf.emplace_back("last");
+    ASSERT_EQ(buf, CCircularBuffer<std::string>({"yy", "xxx", "last"}));
+    buf.emplace_front("first");
+    ASSERT_EQ(buf, CCircularBuffer<std::string>({"first", "yy", "xxx"}));
+}
+
+TEST (BufferTestSuite, NoCopyOnMoveTest) {
+    CCircularBuffer<CTracked> buf(4);
+    CTracked::reset();
+    for (int32_t i = 0; i < 10; ++i) {
+        CTracked value(i);
+        buf.push_back(std::move(value));
+        buf.push_front(CTracked(-i));
+        buf.emplace_back(i);
+    }
+    buf.insert(buf.cbegin() + 2, CTracked(100));
+    buf.pop_front();
+    buf.insert(buf.cbegin() + 1, CTracked(200));
+    CCircularBuffer<CTracked> moved(std::move(buf));
+    buf = std::move(moved);
+    ASSERT_EQ(CTracked::copies, 0);
+    ASSERT_EQ(CTracked::allocations, 32);
+    ASSERT_EQ(*buf[1].payload, 200);
+    ASSERT_EQ(*buf.back().payload, 9);
+}
+
+TEST (BufferTestSuite, LiveSlotsTest) {
+    {
+        CCircularBuffer<CLive> buf(6);
+        ASSERT_EQ(CLive::alive, 0);
+        for (int32_t i = 0; i < 9; ++i)
+            buf.push_back(i);
+        ASSERT_EQ(CLive::alive, 6);
+        buf.insert(buf.cbegin() + 2, 2, CLive(100));
+        ASSERT_EQ(CLive::alive, 6);
+        buf.pop_back();
+        buf.pop_front(2);
+        buf.insert(buf.cbegin() + 1, {CLive(7), CLive(8)});
+        ASSERT_EQ(CLive::alive, 5);
+        buf.erase(buf.cbegin() + 1, buf.cbegin() + 3);
+        ASSERT_EQ(CLive::alive, 3);
+        buf.resize(2);
+        ASSERT_EQ(CLive::alive, 2);
+        buf.resize(10);
+        CCircularBuffer<CLive> copy(buf);
+        ASSERT_EQ(CLive::alive, 4);
+        copy.assign(5, CLive(1));
+        ASSERT_EQ(CLive::alive, 7);
+        buf = copy;
+        ASSERT_EQ(CLive::alive, 10);
+        copy.clear();
+        ASSERT_EQ(CLive::alive, 5);
+    }
+    ASSERT_EQ(CLive::alive, 0);
+}
+
+TEST (BufferTestSuite, StringInsertEraseTest) {
+    CCircularBuffer<std::string> buf({"a", "b", "c"});
+    buf.resize(6);
+    buf.insert(buf.cbegin() + 1, {"x", "y"});
+    ASSERT_EQ(buf, CCircularBuffer<std::string>({"a", "x", "y", "b", "c"}));
+    buf.insert(buf.cbegin() + 4, 3, "z");
+    ASSERT_EQ(buf, CCircularBuffer<std::string>({"a", "x", "z", "z", "z", "c"}));
+    buf.erase(buf.cbegin() + 2);
+    ASSERT_EQ(buf, CCircularBuffer<std::string>({"a", "x", "z", "z", "c"}));
+    buf.erase(buf.cbegin() + 3, buf.cend());
+    ASSERT_EQ(buf, CCircularBuffer<std::string>({"a", "x", "z"}));
+    std::vector<std::string> words = {"1", "2", "3", "4", "5", "6", "7"};
+    buf.push_back(words.begin(), words.end());
+    ASSERT_EQ(buf, CCircularBuffer<std::string>({"2", "3", "4", "5", "6", "7"}));
+}
+
+TEST (BufferTestSuite, TrivialClearTest) {
+    CCircularBuffer<int64_t> buf(1000000, 7);
+    CCircularBuffer<int64_t> copy(buf);
+    buf.clear();
+    ASSERT_EQ(buf.size(), 0);
+    ASSERT_EQ(buf.capacity(), 1000000);
+    ASSERT_EQ(copy.size(), 1000000);
+    ASSERT_EQ(copy[999999], 7);
+}
+
+TEST (BufferTestSuite, ShortestSideInsertEraseTest) {
+    CCircularBuffer<int32_t> ints(37);
+    CompareWithDeque(ints, [](int32_t i) { return i; });
+    CCircularBuffer<std::string, std::allocator<std::string>, CPowerOfTwoCapacity> strings(30);
+    CompareWithDeque(strings, [](int32_t i) { return std::to_string(i) + std::string(20, 's'); });
+}
+
 // ExtendedBufferTests
 TEST(BufferExtTestSuite, CreationTest1) {
     CCircularBufferExt<uint32_t> buf(6);
@@ -247,7 +664,430 @@ TEST (BufferExtTestSuite, AssignTest) {
     ASSERT_EQ(buf1.size(), 6);
 }
 
+TEST (BufferExtTestSuite, StringGrowthTest) {
+    CCircularBufferExt<std::string> buf(2);
+    for (int32_t i = 0; i < 10; ++i)
+        buf.push_back(std::to_string(i));
+    buf.push_front("front");
+    ASSERT_EQ(buf.size(), 11);
+    ASSERT_EQ(buf.capacity(), 16);
+    buf.insert(buf.cbegin() + 2, 6, "x");
+    ASSERT_EQ(buf.size(), 17);
+    ASSERT_EQ(buf.capacity(), 32);
+    buf.erase(buf.cbegin() + 1, buf.cbegin() + 9);
+    ASSERT_EQ(buf, CCircularBufferExt<std::string>({"front", "2", "3", "4", "5", "6", "7", "8", "9"}));
+}
+
+// StaticBufferTests
+TEST(StaticBufferTestSuite, LayoutTest) {
+    static_assert(std::is_same_v<CStaticIndex<16>, uint8_t>);
+    static_assert(std::is_same_v<CStaticIndex<255>, uint8_t>);
+    static_assert(std::is_same_v<CStaticIndex<256>, uint16_t>);
+    static_assert(std::is_same_v<CStaticIndex<70000>, uint32_t>);
+    ASSERT_EQ((sizeof(CStaticCircularBuffer<uint32_t, 16>)), 16 * sizeof(uint32_t) + 4);
+    ASSERT_EQ((CStaticCircularBuffer<uint32_t, 16>::capacity()), 16);
+}
+
+TEST(StaticBufferTestSuite, PushPopTest) {
+    using Buffer = CStaticCircularBuffer<int32_t, 5>;
+    Buffer buf;
+    buf.push_back(3);
+    buf.push_front(2);
+    buf.push_front(1);
+    buf.push_back(4);
+    buf.push_back(5);
+    ASSERT_EQ(buf, Buffer({1, 2, 3, 4, 5}));
+    buf.push_back(6);
+    ASSERT_EQ(buf.front(), 2);
+    buf.push_front(0);
+    ASSERT_EQ(buf.back(), 5);
+    buf.pop_back();
+    buf.pop_front();
+    ASSERT_EQ(buf, Buffer({2, 3, 4}));
+    ASSERT_EQ(buf.array_one().second + buf.array_two().second, 3);
+}
+
+TEST(StaticBufferTestSuite, IteratorTest) {
+    using Buffer = CStaticCircularBuffer<int32_t, 6>;
+    Buffer buf({5, 1, 4});
+    buf.push_front(2);
+    buf.push_front(6);
+    buf.push_back(3);
+    std::sort(buf.begin(), buf.end());
+    ASSERT_EQ(buf, Buffer({1, 2, 3, 4, 5, 6}));
+    ASSERT_EQ(*buf.crbegin(), 6);
+    ASSERT_EQ(buf.end() - buf.begin(), 6);
+    ASSERT_EQ(buf.begin()[4], 5);
+    std::vector<int32_t> reversed(buf.crbegin(), buf.crend());
+    ASSERT_EQ(reversed, std::vector<int32_t>({6, 5, 4, 3, 2, 1}));
+}
+
+TEST(StaticBufferTestSuite, GenericIteratorTest) {
+    CCircularBuffer<int> dynamic(8);
+    CheckWrappedIterators(dynamic);
+    CStaticCircularBuffer<int, 8> fixed;
+    CheckWrappedIterators(fixed);
+}
+
+TEST(StaticBufferTestSuite, PushAliasTest) {
+    CStaticCircularBuffer<std::string, 3> buf;
+    for (const char* value : {"first string longer than sso", "second string longer than sso", "third"})
+        buf.push_back(value);
+    buf.push_back(buf.front());
+    buf.push_front(buf.back());
+    buf.emplace_back(buf.front());
+    ASSERT_EQ(std::vector<std::string>(buf.begin(), buf.end()),
+              std::vector<std::string>({"second string longer than sso", "third", "first string longer than sso"}));
+}
+
+TEST(StaticBufferTestSuite, InsertEraseTest) {
+    CStaticCircularBuffer<int32_t, 30> ints;
+    CompareWithDeque(ints, [](int32_t i) { return i; });
+    CStaticCircularBuffer<std::string, 30> strings;
+    CompareWithDeque(strings, [](int32_t i) { return std::to_string(i) + std::string(20, 's'); });
+}
+
+TEST(StaticBufferTestSuite, LiveSlotsTest) {
+    {
+        CStaticCircularBuffer<CLive, 6> buf;
+        for (int32_t i = 0; i < 8; ++i)
+            buf.emplace_back(i);
+        ASSERT_EQ(CLive::alive, 6);
+        buf.insert(buf.cbegin() + 2, 2, CLive(100));
+        ASSERT_EQ(CLive::alive, 6);
+        buf.erase(buf.cbegin() + 1, buf.cbegin() + 4);
+        ASSERT_EQ(CLive::alive, 3);
+        CStaticCircularBuffer<CLive, 6> copy(buf);
+        ASSERT_EQ(CLive::alive, 6);
+        CStaticCircularBuffer<CLive, 6> moved(std::move(copy));
+        ASSERT_EQ(CLive::alive, 6);
+        ASSERT_TRUE(copy.empty());
+        swap(moved, buf);
+        ASSERT_EQ(moved, buf);
+        buf.clear();
+        ASSERT_EQ(CLive::alive, 3);
+    }
+    ASSERT_EQ(CLive::alive, 0);
+}
+
+TEST(BufferExtTestSuite, GrowthPolicyTest) {
+    CCircularBufferExt<int32_t, std::allocator<int32_t>, CGeometricGrowth<3, 10>> buf;
+    buf.push_back(0);
+    ASSERT_EQ(buf.capacity(), 10);
+    for (int32_t i = 1; i < 11; ++i)
+        buf.push_back(i);
+    ASSERT_EQ(buf.capacity(), 30);
+    buf.insert(buf.cbegin() + 5, 40, 7);
+    ASSERT_EQ(buf.capacity(), 90);
+    ASSERT_EQ(buf.size(), 51);
+
+    CRuntimeGrowth growth;
+    growth.factor = 1.5;
+    growth.minIncrement = 4;
+    CCircularBufferExt<int32_t, std::allocator<int32_t>, CRuntimeGrowth> runtime(4, growth);
+    for (int32_t i = 0; i < 5; ++i)
+        runtime.push_back(i);
+    ASSERT_EQ(runtime.capacity(), 8);
+    for (int32_t i = 5; i < 9; ++i)
+        runtime.push_back(i);
+    ASSERT_EQ(runtime.capacity(), 12);
+    ASSERT_EQ(runtime, CCircularBufferExt<int32_t>({0, 1, 2, 3, 4, 5, 6, 7, 8}));
+}
+
+TEST(BufferExtTestSuite, ReserveTest) {
+    CCircularBufferExt<std::string> buf(4);
+    for (int32_t i = 0; i < 6; ++i)
+        buf.push_front(std::to_string(i));
+    buf.reserve(100);
+    ASSERT_EQ(buf.capacity(), 100);
+    ASSERT_EQ(buf, CCircularBufferExt<std::string>({"5", "4", "3", "2", "1", "0"}));
+    const std::string* first = &buf.front();
+    for (int32_t i = 6; i < 100; ++i)
+        buf.push_back(std::to_string(i));
+    ASSERT_EQ(buf.capacity(), 100);
+    ASSERT_EQ(&buf.front(), first);
+    buf.reserve(10);
+    ASSERT_EQ(buf.capacity(), 100);
+}
+
+TEST(BufferExtTestSuite, ShrinkTest) {
+    CCircularBufferExt<int32_t, std::allocator<int32_t>, CGeometricGrowth<2>, CWatermarkShrink<25, 50, 4>> buf(4);
+    for (int32_t i = 0; i < 64; ++i)
+        buf.push_back(i);
+    ASSERT_EQ(buf.capacity(), 64);
+    buf.pop_front(47);
+    ASSERT_EQ(buf.capacity(), 64);
+    buf.pop_front();
+    ASSERT_EQ(buf.capacity(), 32);
+    ASSERT_EQ(buf.size(), 16);
+    ASSERT_EQ(buf.front(), 48);
+    for (int32_t i = 0; i < 10; ++i) {
+        buf.push_back(i);
+        buf.pop_back();
+        buf.pop_back();
+        buf.push_front(i);
+    }
+    ASSERT_EQ(buf.capacity(), 32);
+    buf.erase(buf.cbegin() + 2, buf.cbegin() + 12);
+    ASSERT_EQ(buf.capacity(), 12);
+    ASSERT_EQ(buf.size(), 6);
+    buf.clear();
+    ASSERT_EQ(buf.capacity(), 4);
+    ASSERT_EQ(buf.footprint().current, 4 * sizeof(int32_t));
+    ASSERT_EQ(buf.footprint().peak, 64 * sizeof(int32_t));
+
+    buf.reserve(40);
+    for (int32_t i = 0; i < 20; ++i)
+        buf.push_back(i);
+    buf.pop_front(19);
+    ASSERT_EQ(buf.capacity(), 40);
+}
+
+TEST(BufferExtTestSuite, ShrinkToFitTest) {
+    CCircularBufferExt<std::string> buf(4);
+    for (int32_t i = 0; i < 9; ++i)
+        buf.push_back(std::to_string(i));
+    buf.pop_front(3);
+    buf.push_back("9");
+    buf.push_front("x");
+    ASSERT_EQ(buf.capacity(), 16);
+    buf.shrink_to_fit();
+    ASSERT_EQ(buf.capacity(), 8);
+    ASSERT_EQ(buf, CCircularBufferExt<std::string>({"x", "3", "4", "5", "6", "7", "8", "9"}));
+    ASSERT_EQ(buf.footprint().peak, 16 * sizeof(std::string));
+}
+
+TEST(BufferTestSuite, ConsumeTest) {
+    CCircularBuffer<std::string> buf(6);
+    for (int32_t i = 0; i < 9; ++i)
+        buf.push_back(std::to_string(i));
+    std::vector<size_t> spans;
+    std::vector<std::string> out;
+    size_t n = buf.consume_all([&spans, &out](std::string* first, size_t count) {
+        spans.push_back(count);
+        std::move(first, first + count, std::back_inserter(out));
+    });
+    ASSERT_EQ(n, 6);
+    ASSERT_EQ(spans, std::vector<size_t>({3, 3}));
+    ASSERT_EQ(out, std::vector<std::string>({"3", "4", "5", "6", "7", "8"}));
+    ASSERT_TRUE(buf.empty());
+
+    for (int32_t i = 0; i < 6; ++i)
+        buf.push_back(std::to_string(i));
+    buf.pop_front(2);
+    buf.push_back("6");
+    buf.push_back("7");
+    // Stops inside the first span at the first "4".
+    n = buf.consume(5, [](std::string* first, size_t count) -> size_t {
+        return std::find(first, first + count, "4") - first;
+    });
+    ASSERT_EQ(n, 2);
+    ASSERT_EQ(buf.front(), "4");
+    int32_t sum = 0;
+    n = buf.consume(3, [&sum](const std::string* first, size_t count) -> size_t {
+        for (size_t i = 0; i < count; ++i)
+            sum += std::stoi(first[i]);
+        return count;
+    });
+    ASSERT_EQ(n, 3);
+    ASSERT_EQ(sum, 4 + 5 + 6);
+    ASSERT_EQ(buf, CCircularBuffer<std::string>({"7"}));
+    ASSERT_EQ(buf.consume(0, [](std::string*, size_t) {}), 0);
+}
+
+TEST(BufferTestSuite, AllocatorPropagationTest) {
+    using Sticky = CCircularBuffer<std::string, CTaggedAllocator<std::string, false>>;
+    Sticky a(4, CTaggedAllocator<std::string, false>(1));
+    a.push_back("a");
+    a.push_back("b");
+    Sticky copy(a);
+    ASSERT_EQ(copy.get_allocator().id, 101);
+    ASSERT_EQ(copy, a);
+    Sticky b(2, CTaggedAllocator<std::string, false>(2));
+    b = a;
+    ASSERT_EQ(b.get_allocator().id, 2);
+    ASSERT_EQ(b.capacity(), 4);
+    b.push_back("c");
+    Sticky c(8, CTaggedAllocator<std::string, false>(3));
+    c = std::move(b);
+    ASSERT_EQ(c.get_allocator().id, 3);
+    ASSERT_EQ(c, Sticky({"a", "b", "c"}));
+    ASSERT_TRUE(b.empty());
+
+    using Follows = CCircularBuffer<std::string, CTaggedAllocator<std::string, true>>;
+    Follows d(4, CTaggedAllocator<std::string, true>(1));
+    d.push_back("d");
+    Follows e(4, CTaggedAllocator<std::string, true>(2));
+    e = d;
+    ASSERT_EQ(e.get_allocator().id, 1);
+    Follows f(4, CTaggedAllocator<std::string, true>(3));
+    f.push_back("f");
+    swap(e, f);
+    ASSERT_EQ(e.get_allocator().id, 3);
+    ASSERT_EQ(e.front(), "f");
+    ASSERT_EQ(f.get_allocator().id, 1);
+    f = std::move(e);
+    ASSERT_EQ(f.get_allocator().id, 3);
+    ASSERT_EQ(f.front(), "f");
+}
+
+TEST(BufferTestSuite, PmrArenaTest) {
+    alignas(std::max_align_t) char arena[1 << 14];
+    std::pmr::monotonic_buffer_resource resource(arena, sizeof(arena), std::pmr::null_memory_resource());
+    CPmrCircularBuffer<std::pmr::string> buf(4, &resource);
+    for (int32_t i = 0; i < 6; ++i)
+        buf.push_back(std::pmr::string(std::to_string(i) + std::string(40, 's')));
+    ASSERT_EQ(buf.size(), 4);
+    ASSERT_EQ(buf.front().get_allocator().resource(), &resource);
+    buf.resize(8);
+    ASSERT_EQ(buf.get_allocator().resource(), &resource);
+    ASSERT_EQ(buf.front().substr(0, 1), "2");
+
+    static_assert(std::is_nothrow_move_constructible_v<CPmrCircularBufferExt<int32_t>>);
+    static_assert(!std::is_nothrow_move_assignable_v<CPmrCircularBufferExt<int32_t>>);
+    static_assert(std::is_nothrow_move_assignable_v<CCircularBufferExt<int32_t>>);
+    CPmrCircularBufferExt<int32_t> ext(&resource);
+    for (int32_t i = 0; i < 100; ++i)
+        ext.push_back(i);
+    ASSERT_EQ(ext.size(), 100);
+    ASSERT_EQ(ext.back(), 99);
+    ASSERT_EQ(ext.get_allocator().resource(), &resource);
+}
+
+TEST(SlidingWindowTestSuite, AggregatesTest) {
+    CSlidingWindow<double> window(100);
+    std::deque<double> expected;
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> dist(-1000, 1000);
+    for (int i = 0; i < 5000; ++i) {
+        double value = dist(gen) + 1e6;
+        window.push_back(value);
+        expected.push_back(value);
+        if (expected.size() > 100)
+            expected.pop_front();
+        if (i % 7 == 0) {
+            window.pop_front();
+            expected.pop_front();
+        }
+        if (expected.empty())
+            continue;
+        double sum = 0;
+        for (double sample : expected)
+            sum += sample;
+        double mean = sum / expected.size();
+        double squares = 0;
+        for (double sample : expected)
+            squares += (sample - mean) * (sample - mean);
+        ASSERT_EQ(window.size(), expected.size());
+        ASSERT_NEAR(window.sum(), sum, 1e-6);
+        ASSERT_NEAR(window.mean(), mean, 1e-6);
+        ASSERT_NEAR(window.variance(), expected.size() < 2 ? 0 : squares / expected.size(), 1e-6);
+        ASSERT_EQ(window.min(), *std::min_element(expected.begin(), expected.end()));
+        ASSERT_EQ(window.max(), *std::max_element(expected.begin(), expected.end()));
+    }
+}
+
+TEST(SlidingWindowTestSuite, IntegerTest) {
+    CSlidingWindow<int> window(3);
+    for (int value : {5, 1, 4, 1, 5, 9, 2, 6})
+        window.push_back(value);
+    ASSERT_TRUE(window.full());
+    ASSERT_EQ(window.sum(), 17);
+    ASSERT_EQ(window.min(), 2);
+    ASSERT_EQ(window.max(), 9);
+    ASSERT_NEAR(window.variance(), 74.0 / 9, 1e-12);
+    window.pop_front();
+    window.pop_front();
+    ASSERT_EQ(window.min(), 6);
+    ASSERT_EQ(window.max(), 6);
+    ASSERT_EQ(window.variance(), 0);
+    window.pop_front();
+    ASSERT_TRUE(window.empty());
+    ASSERT_EQ(window.sum(), 0);
+    window.push_back(-3);
+    window.push_back(3);
+    ASSERT_EQ(window.mean(), 0);
+    ASSERT_EQ(window.min(), -3);
+    window.clear();
+    ASSERT_TRUE(window.empty());
+    window.push_back(8);
+    ASSERT_EQ(window.min(), 8);
+    ASSERT_EQ(window.max(), 8);
+}
+
+TEST(SlidingWindowTestSuite, CompensatedSumTest) {
+    CSlidingWindow<double> window(4);
+    window.push_back(1e16);
+    for (int i = 0; i < 3; ++i)
+        window.push_back(1);
+    window.push_back(0);
+    ASSERT_EQ(window.sum(), 3);
+    CCompensatedSum sum;
+    sum.add(1);
+    sum.add(1e100);
+    sum.add(1);
+    sum.add(-1e100);
+    ASSERT_EQ(sum.value(), 2);
+}
+
+TEST(StatsTestSuite, CountersTest) {
+    using CCountedBuffer = CCircularBuffer<int, std::allocator<int>, CModuloCapacity, CCountingStats>;
+    static_assert(sizeof(CCountedBuffer) == sizeof(CCircularBuffer<int>) + sizeof(CCountingStats));
+    CCountedBuffer buf(4);
+    for (int i = 0; i < 10; ++i)
+        buf.push_back(i);
+    buf.erase(buf.cbegin() + 1);
+    buf.insert(buf.cbegin() + 2, 42);
+    buf.insert(buf.cbegin() + 1, 7);
+    ASSERT_EQ(std::vector<int>(buf.begin(), buf.end()), std::vector<int>({7, 8, 42, 9}));
+    buf.resize(8);
+    buf.resize(8);
+    CBufferStats stats = buf.stats();
+    ASSERT_EQ(stats.overwrites, 7);
+    ASSERT_EQ(stats.highWater, 4);
+    ASSERT_EQ(stats.wraps, 3);
+    ASSERT_EQ(stats.resizes, 1);
+    ASSERT_EQ(stats.shifted, 2);
+    for (int i = 0; i < 5; ++i)
+        buf.push_back(i);
+    stats = buf.stats();
+    ASSERT_EQ(stats.overwrites, 8);
+    ASSERT_EQ(stats.highWater, 8);
+    ASSERT_EQ(stats.wraps, 4);
+    CCountedBuffer copy(buf);
+    ASSERT_EQ(copy.stats().overwrites, 0);
+    ASSERT_EQ(copy.stats().highWater, 8);
+}
+
+TEST(StatsTestSuite, BackwardWrapTest) {
+    CCircularBuffer<int, std::allocator<int>, CPowerOfTwoCapacity, CCountingStats> buf(4);
+    buf.push_front(1);
+    buf.push_back(2);
+    buf.pop_back();
+    ASSERT_EQ(buf.stats().wraps, 1);
+    buf.pop_front();
+    ASSERT_EQ(buf.stats().wraps, 2);
+    CCircularBuffer<int> plain(4);
+    plain.push_back(1);
+    ASSERT_EQ(plain.stats().highWater, 0);
+}
+
+TEST(StatsTestSuite, ExtResizeTest) {
+    CCircularBufferExt<int, std::allocator<int>, CGeometricGrowth<2>, CWatermarkShrink<25, 50, 4>, CCountingStats> buf(2);
+    for (int i = 0; i < 10; ++i)
+        buf.push_back(i);
+    ASSERT_EQ(buf.capacity(), 16);
+    ASSERT_EQ(buf.stats().resizes, 3);
+    for (int i = 0; i < 9; ++i)
+        buf.pop_front();
+    ASSERT_EQ(buf.capacity(), 4);
+    CBufferStats stats = buf.stats();
+    ASSERT_EQ(stats.resizes, 5);
+    ASSERT_EQ(stats.overwrites, 0);
+    ASSERT_EQ(stats.highWater, 10);
+}
+
 int main (int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
-}
\ No newline at end of file
+}
@@ -0,0 +1,233 @@
+#include "lib/CCircularBuffer/CSpscCircularBuffer.h"
+#include "lib/CCircularBuffer/CMpmcCircularBuffer.h"
+#include "lib/CCircularBuffer/CBlockingCircularBuffer.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(SpscBufferTestSuite, CreationTest) {
+    CSpscCircularBuffer<uint32_t> buf(6);
+    ASSERT_EQ(buf.capacity(), 8);
+    ASSERT_EQ(buf.size(), 0);
+    ASSERT_TRUE(buf.empty());
+}
+
+TEST(SpscBufferTestSuite, PushPopTest) {
+    CSpscCircularBuffer<std::string> buf(2);
+    std::string value;
+    ASSERT_FALSE(buf.try_pop(value));
+    ASSERT_TRUE(buf.try_push("first"));
+    ASSERT_TRUE(buf.try_push(std::string("second")));
+    ASSERT_FALSE(buf.try_push("third"));
+    ASSERT_TRUE(buf.full());
+    ASSERT_EQ(*buf.front(), "first");
+    ASSERT_TRUE(buf.try_pop(value));
+    ASSERT_EQ(value, "first");
+    ASSERT_TRUE(buf.try_push("third"));
+    ASSERT_TRUE(buf.try_pop(value));
+    ASSERT_EQ(value, "second");
+    ASSERT_TRUE(buf.try_pop(value));
+    ASSERT_EQ(value, "third");
+    ASSERT_TRUE(buf.empty());
+}
+
+TEST(SpscBufferTestSuite, TwoThreadsTest) {
+    const uint64_t kMessages = 1000000;
+    CSpscCircularBuffer<uint64_t> buf(1024);
+    std::thread producer([&buf] {
+        for (uint64_t i = 0; i < kMessages; ++i)
+            while (!buf.try_push(i))
+                std::this_thread::yield();
+    });
+    uint64_t expected = 0;
+    uint64_t value;
+    while (expected < kMessages) {
+        if (buf.try_pop(value)) {
+            ASSERT_EQ(value, expected);
+            ++expected;
+        } else
+            std::this_thread::yield();
+    }
+    producer.join();
+    ASSERT_TRUE(buf.empty());
+}
+
+TEST(MpmcBufferTestSuite, EnqueueDequeueTest) {
+    CMpmcCircularBuffer<std::string> buf(3);
+    ASSERT_EQ(buf.capacity(), 4);
+    std::string value;
+    ASSERT_FALSE(buf.try_dequeue(value));
+    for (int i = 0; i < 4; ++i)
+        ASSERT_TRUE(buf.try_enqueue(std::to_string(i)));
+    ASSERT_FALSE(buf.try_enqueue("4"));
+    ASSERT_EQ(buf.size(), 4);
+    ASSERT_TRUE(buf.try_dequeue(value));
+    ASSERT_EQ(value, "0");
+    ASSERT_TRUE(buf.try_enqueue("4"));
+    for (int i = 1; i < 5; ++i) {
+        ASSERT_TRUE(buf.try_dequeue(value));
+        ASSERT_EQ(value, std::to_string(i));
+    }
+    ASSERT_TRUE(buf.empty());
+}
+
+TEST(MpmcBufferTestSuite, BulkTest) {
+    CMpmcCircularBuffer<int32_t> buf(8);
+    std::vector<int32_t> in = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    ASSERT_EQ(buf.try_enqueue_bulk(in.begin(), in.size()), 8);
+    ASSERT_EQ(buf.try_enqueue_bulk(in.begin(), 1), 0);
+    std::vector<int32_t> out(10);
+    ASSERT_EQ(buf.try_dequeue_bulk(out.begin(), 5), 5);
+    ASSERT_EQ(buf.try_enqueue_bulk(in.begin() + 8, 2), 2);
+    ASSERT_EQ(buf.try_dequeue_bulk(out.begin() + 5, 10), 5);
+    ASSERT_EQ(out, in);
+    ASSERT_EQ(buf.try_dequeue_bulk(out.begin(), 10), 0);
+}
+
+namespace {
+
+// A string whose copy throws for the value "throw".
+struct CThrowingCopy {
+    std::string value;
+
+    CThrowingCopy(const char* v) : value(v) {}
+
+    CThrowingCopy(const CThrowingCopy& other) : value(other.value) {
+        if (value == "throw")
+            throw std::runtime_error("copy");
+    }
+
+    CThrowingCopy(CThrowingCopy&&) = default;
+
+    CThrowingCopy& operator=(CThrowingCopy&&) = default;
+};
+
+}
+
+TEST(MpmcBufferTestSuite, ThrowingCopyTest) {
+    CMpmcCircularBuffer<CThrowingCopy> buf(8);
+    std::vector<CThrowingCopy> in;
+    for (const char* value : {"a", "b", "throw", "c"})
+        in.emplace_back(value);
+    ASSERT_THROW(buf.try_enqueue_bulk(in.begin(), in.size()), std::runtime_error);
+    ASSERT_THROW(buf.try_enqueue(in[2]), std::runtime_error);
+    ASSERT_TRUE(buf.try_enqueue(in[3]));
+    std::vector<CThrowingCopy> out(4, "");
+    ASSERT_EQ(buf.try_dequeue_bulk(out.begin(), 2), 2);
+    ASSERT_EQ(out[0].value, "a");
+    ASSERT_EQ(out[1].value, "b");
+    // Skips the two slots of the failed bulk enqueue and the one of the failed single enqueue.
+    CThrowingCopy value("");
+    ASSERT_TRUE(buf.try_dequeue(value));
+    ASSERT_EQ(value.value, "c");
+    ASSERT_FALSE(buf.try_dequeue(value));
+    ASSERT_TRUE(buf.empty());
+    ASSERT_EQ(buf.try_enqueue_bulk(in.begin(), 2), 2);
+    ASSERT_THROW(buf.try_enqueue_bulk(in.begin() + 2, 1), std::runtime_error);
+    ASSERT_EQ(buf.try_dequeue_bulk(out.begin(), 4), 2);
+    ASSERT_EQ(buf.try_dequeue_bulk(out.begin(), 4), 0);
+}
+
+TEST(MpmcBufferTestSuite, StressTest) {
+    const size_t kThreads = 4;
+    const uint64_t kPerProducer = 100000;
+    CMpmcCircularBuffer<uint64_t> buf(64);
+    std::vector<std::atomic<uint32_t>> seen(kThreads * kPerProducer);
+    std::atomic<uint64_t> consumed(0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&buf, t] {
+            for (uint64_t i = t * kPerProducer; i < (t + 1) * kPerProducer;) {
+                uint64_t batch[3] = {i, i + 1, i + 2};
+                size_t n = (i + 3 <= (t + 1) * kPerProducer) ? 3 : 1;
+                size_t done = (t % 2 == 0) ? buf.try_enqueue_bulk(batch, n) : buf.try_enqueue(i);
+                if (done == 0)
+                    std::this_thread::yield();
+                i += done;
+            }
+        });
+        threads.emplace_back([&buf, &seen, &consumed, t] {
+            uint64_t batch[4];
+            while (consumed.load() < kThreads * kPerProducer) {
+                size_t n = (t % 2 == 0) ? buf.try_dequeue_bulk(batch, 4) : buf.try_dequeue(batch[0]);
+                for (size_t i = 0; i < n; ++i)
+                    seen[batch[i]]++;
+                if (n == 0)
+                    std::this_thread::yield();
+                consumed += n;
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    for (std::atomic<uint32_t>& count : seen)
+        ASSERT_EQ(count.load(), 1);
+    ASSERT_TRUE(buf.empty());
+}
+
+TEST(BlockingBufferTestSuite, TimeoutTest) {
+    CBlockingCircularBuffer<int> buf(2);
+    int value = 0;
+    ASSERT_FALSE(buf.pop_for(value, std::chrono::milliseconds(5)));
+    ASSERT_TRUE(buf.push_for(1, std::chrono::milliseconds(5)));
+    ASSERT_TRUE(buf.try_push(2));
+    ASSERT_FALSE(buf.push_for(3, std::chrono::milliseconds(5)));
+    ASSERT_FALSE(buf.try_push(3));
+    ASSERT_EQ(buf.size(), 2);
+    ASSERT_TRUE(buf.pop_for(value, std::chrono::milliseconds(0)));
+    ASSERT_EQ(value, 1);
+    ASSERT_TRUE(buf.try_pop(value));
+    ASSERT_EQ(value, 2);
+    ASSERT_TRUE(buf.empty());
+}
+
+TEST(BlockingBufferTestSuite, WakeUpTest) {
+    CBlockingCircularBuffer<int, CSpinParkWait<0, 0>> buf(2);
+    std::thread consumer([&buf] {
+        int value = 0;
+        buf.pop(value);
+        ASSERT_EQ(value, 42);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    buf.push(42);
+    consumer.join();
+    ASSERT_TRUE(buf.empty());
+}
+
+template<typename WaitStrategy>
+void RunBlockingProducersConsumers(uint64_t perProducer) {
+    const size_t kThreads = 2;
+    CBlockingCircularBuffer<uint64_t, WaitStrategy> buf(4);
+    std::atomic<uint64_t> sum(0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&buf, perProducer] {
+            for (uint64_t i = 1; i <= perProducer; ++i)
+                buf.push(i);
+        });
+        threads.emplace_back([&buf, &sum, perProducer] {
+            uint64_t value;
+            for (uint64_t i = 0; i < perProducer; ++i) {
+                buf.pop(value);
+                sum += value;
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    ASSERT_EQ(sum.load(), kThreads * perProducer * (perProducer + 1) / 2);
+    ASSERT_TRUE(buf.empty());
+}
+
+TEST(BlockingBufferTestSuite, StrategiesTest) {
+    RunBlockingProducersConsumers<CBusySpinWait>(200);
+    RunBlockingProducersConsumers<CSpinYieldWait<>>(5000);
+    RunBlockingProducersConsumers<CSpinParkWait<>>(5000);
+    RunBlockingProducersConsumers<CSpinParkWait<0, 0>>(5000);
+}
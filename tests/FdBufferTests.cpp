@@ -0,0 +1,86 @@
+#ifdef __linux__
+#include "lib/CCircularBuffer/CCircularBuffer.h"
+#include "lib/CCircularBuffer/CCircularBufferExt.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+std::string Contents(CCircularBuffer<char>& buf) { return std::string(buf.begin(), buf.end()); }
+
+}
+
+TEST(FdBufferTestSuite, PipeWrappedTest) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    CCircularBuffer<char> buf(8);
+    buf.push_back("xxxxxx", 6);
+    buf.pop_front(6);
+    ASSERT_EQ(write(fds[1], "abcdefghij", 10), 10);
+    ASSERT_EQ(buf.read_from_fd(fds[0], 100), 8);
+    ASSERT_EQ(Contents(buf), "abcdefgh");
+    ASSERT_EQ(buf.read_from_fd(fds[0], 100), 0);
+    ASSERT_EQ(buf.array_two().second, 6);
+
+    ASSERT_EQ(buf.write_to_fd(fds[1], 5), 5);
+    ASSERT_EQ(Contents(buf), "fgh");
+    ASSERT_EQ(buf.read_from_fd(fds[0], 4), 4);
+    ASSERT_EQ(Contents(buf), "fghijab");
+    ASSERT_EQ(buf.write_to_fd(fds[1], 100), 7);
+    ASSERT_TRUE(buf.empty());
+    char out[16];
+    ASSERT_EQ(read(fds[0], out, sizeof(out)), 10);
+    ASSERT_EQ(std::string(out, 10), "cdefghijab");
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(FdBufferTestSuite, SocketPairTest) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    CCircularBuffer<char> out(5);
+    CCircularBuffer<char> in(5);
+    std::string sent;
+    std::string received;
+    for (int round = 0; round < 20; ++round) {
+        for (size_t i = 0; !out.full(); ++i)
+            out.push_back(static_cast<char>('a' + (round * 3 + i) % 26));
+        sent += Contents(out).substr(0, 3);
+        ASSERT_EQ(out.write_to_fd(fds[0], 3), 3);
+        ASSERT_EQ(in.read_from_fd(fds[1], 3), 3);
+        received += Contents(in);
+        in.pop_front(in.size());
+    }
+    ASSERT_EQ(received, sent);
+
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    ASSERT_EQ(in.read_from_fd(fds[1], 5), -1);
+    ASSERT_EQ(errno, EAGAIN);
+    ASSERT_TRUE(in.empty());
+    close(fds[0]);
+    ASSERT_EQ(in.read_from_fd(fds[1], 5), 0);
+    close(fds[1]);
+}
+
+TEST(FdBufferTestSuite, ExtGrowsTest) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    CCircularBufferExt<char> buf(2);
+    ASSERT_EQ(write(fds[1], "abcdef", 6), 6);
+    ASSERT_EQ(buf.read_from_fd(fds[0], 6), 2);
+    ASSERT_EQ(buf.read_from_fd(fds[0], 6), 2);
+    ASSERT_EQ(buf.capacity(), 4);
+    ASSERT_EQ(buf.read_from_fd(fds[0], 6), 2);
+    ASSERT_EQ(std::string(buf.begin(), buf.end()), "abcdef");
+    ASSERT_EQ(buf.write_to_fd(fds[1], 6), 6);
+    ASSERT_TRUE(buf.empty());
+    close(fds[0]);
+    close(fds[1]);
+}
+#endif
@@ -0,0 +1,44 @@
+#ifdef __linux__
+#include "lib/CCircularBuffer/CCircularBuffer.h"
+#include "lib/CCircularBuffer/CCircularBufferExt.h"
+#include "lib/CCircularBuffer/CHugePageAllocator.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+TEST(HugePageAllocatorTestSuite, DefaultOptionsTest) {
+    CCircularBuffer<uint64_t, CHugePageAllocator<uint64_t>> buf(1 << 20);
+    for (uint64_t i = 0; i < (1 << 20) + 10; ++i)
+        buf.push_back(i);
+    ASSERT_EQ(buf.front(), 10);
+    ASSERT_EQ(buf.back(), (1 << 20) + 9);
+    buf.resize(3 << 19);
+    ASSERT_EQ(buf.size(), 1 << 20);
+    ASSERT_EQ(buf.front(), 10);
+}
+
+// The sandbox may have no reserved huge pages and refuse mbind, the allocator must work anyway.
+TEST(HugePageAllocatorTestSuite, FallbackTest) {
+    CHugePageOptions options;
+    options.numaPolicy = ENumaPolicy::kInterleave;
+    options.numaNodes = 1;
+    CHugePageAllocator<std::string> alloc(options);
+    CCircularBufferExt<std::string, CHugePageAllocator<std::string>> buf(4, alloc);
+    for (int32_t i = 0; i < 1000; ++i)
+        buf.push_back(std::to_string(i));
+    ASSERT_EQ(buf.size(), 1000);
+    ASSERT_EQ(buf.back(), "999");
+    ASSERT_EQ(buf.get_allocator(), alloc);
+
+    CHugePageOptions small;
+    small.hugeTlb = false;
+    small.transparentHugePages = false;
+    small.prefault = false;
+    CCircularBuffer<char, CHugePageAllocator<char>> chars(10, CHugePageAllocator<char>(small));
+    chars.push_back('a');
+    ASSERT_EQ(chars.front(), 'a');
+    ASSERT_NE(chars.get_allocator(), CHugePageAllocator<char>());
+}
+#endif
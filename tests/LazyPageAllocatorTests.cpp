@@ -0,0 +1,71 @@
+#ifdef __linux__
+#include "lib/CCircularBuffer/CCircularBuffer.h"
+#include "lib/CCircularBuffer/CLazyPageAllocator.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+// Number of resident pages in the storage of buf.
+template<typename Buffer>
+size_t ResidentPages(Buffer& buf) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t pages = (buf.capacity() * sizeof(typename Buffer::value_type) + page - 1) / page;
+    std::vector<unsigned char> residency(pages);
+    // array_two() always starts at the beginning of the storage.
+    mincore(buf.array_two().first, pages * page, residency.data());
+    size_t resident = 0;
+    for (unsigned char flag : residency)
+        resident += flag & 1;
+
+    return resident;
+}
+
+}
+
+TEST(LazyPageAllocatorTestSuite, ResidentWindowTest) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t perPage = page / sizeof(uint64_t);
+    CCircularBuffer<uint64_t, CLazyPageAllocator<uint64_t>> buf(perPage * 4096);
+    ASSERT_EQ(ResidentPages(buf), 0);
+    for (uint64_t i = 0; i < perPage * 3; ++i)
+        buf.push_back(i);
+    ASSERT_EQ(ResidentPages(buf), 3);
+    buf.pop_front(perPage - 1);
+    ASSERT_EQ(ResidentPages(buf), 3);
+    buf.pop_front();
+    ASSERT_EQ(ResidentPages(buf), 2);
+    for (uint64_t i = 0; i < perPage * 10; ++i) {
+        buf.push_back(i);
+        buf.pop_front();
+    }
+    ASSERT_LE(ResidentPages(buf), 3);
+    ASSERT_EQ(buf.front(), perPage * 10 - perPage * 2);
+    buf.clear();
+    ASSERT_EQ(ResidentPages(buf), 0);
+}
+
+TEST(LazyPageAllocatorTestSuite, WrapTest) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    CCircularBuffer<std::string, CLazyPageAllocator<std::string>> buf(page / sizeof(std::string) * 4);
+    for (size_t i = 0; i < buf.capacity() * 3 + 5; ++i) {
+        buf.push_back(std::to_string(i));
+        if (i % 3 == 0)
+            buf.pop_front();
+    }
+    ASSERT_EQ(buf.back(), std::to_string(buf.capacity() * 3 + 4));
+    while (buf.size() > 2)
+        buf.pop_back();
+    ASSERT_LE(ResidentPages(buf), 2);
+    buf.erase(buf.cbegin());
+    ASSERT_EQ(buf.size(), 1);
+    ASSERT_LE(ResidentPages(buf), 1);
+}
+#endif
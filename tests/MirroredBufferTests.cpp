@@ -0,0 +1,81 @@
+#ifdef __linux__
+#include "lib/CCircularBuffer/CMirroredCircularBuffer.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+TEST(MirroredBufferTestSuite, PageCapacityTest) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    CMirroredCircularBuffer<char> a(1);
+    ASSERT_EQ(a.capacity(), page);
+    CMirroredCircularBuffer<char> b(page + 1);
+    ASSERT_EQ(b.capacity(), 2 * page);
+    CMirroredCircularBuffer<uint64_t> c(10);
+    ASSERT_EQ(c.capacity(), page / sizeof(uint64_t));
+    ASSERT_TRUE(c.empty());
+}
+
+TEST(MirroredBufferTestSuite, StraddlingRecordTest) {
+    CMirroredCircularBuffer<char> buf(1);
+    size_t cap = buf.capacity();
+    std::string filler(cap - 3, 'f');
+    buf.push_back(filler.data(), filler.size());
+    buf.pop_front(filler.size());
+    std::string record = "record straddling the wrap point";
+    buf.push_back(record.data(), record.size());
+    ASSERT_EQ(buf.size(), record.size());
+    std::pair<char*, size_t> span = buf.span(record.size());
+    ASSERT_EQ(span.second, record.size());
+    ASSERT_EQ(std::string(span.first, span.second), record);
+    ASSERT_EQ(buf.data(), span.first);
+    ASSERT_EQ(std::string(buf.begin(), buf.end()), record);
+    ASSERT_EQ(buf[3], 'o');
+    ASSERT_EQ(buf.back(), 't');
+}
+
+TEST(MirroredBufferTestSuite, OverwriteTest) {
+    CMirroredCircularBuffer<int> buf(1);
+    size_t cap = buf.capacity();
+    for (size_t i = 0; i < cap + 5; ++i)
+        buf.push_back(i);
+    ASSERT_TRUE(buf.full());
+    ASSERT_EQ(buf.front(), 5);
+    ASSERT_EQ(buf.back(), cap + 4);
+    for (size_t i = 0; i < cap; ++i)
+        ASSERT_EQ(buf.data()[i], i + 5);
+    std::vector<int> values(cap + 2, 7);
+    values.back() = 9;
+    buf.push_back(values.data(), values.size());
+    ASSERT_EQ(buf.size(), cap);
+    ASSERT_EQ(buf.back(), 9);
+    ASSERT_EQ(buf.pop_front(cap + 1), cap);
+    ASSERT_TRUE(buf.empty());
+    buf.pop_front();
+    buf.pop_back();
+    ASSERT_TRUE(buf.empty());
+    buf.push_back(1);
+    ASSERT_EQ(buf.size(), 1);
+    ASSERT_EQ(buf.front(), 1);
+}
+
+TEST(MirroredBufferTestSuite, FreeSpanCommitTest) {
+    CMirroredCircularBuffer<char> buf(1);
+    size_t cap = buf.capacity();
+    std::string filler(cap - 2, 'f');
+    buf.push_back(filler.data(), filler.size());
+    buf.pop_front(cap - 4);
+    std::pair<char*, size_t> free = buf.free_span();
+    ASSERT_EQ(free.second, cap - 2);
+    std::memcpy(free.first, "abcdef", 6);
+    buf.commit(6);
+    ASSERT_EQ(std::string(buf.data(), buf.size()), "ffabcdef");
+    CMirroredCircularBuffer<char> moved(std::move(buf));
+    ASSERT_EQ(std::string(moved.data(), moved.size()), "ffabcdef");
+}
+#endif
@@ -0,0 +1,155 @@
+#ifdef __linux__
+#include "lib/CCircularBuffer/CPersistentCircularBuffer.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// Layout of the first page, see CPersistentCircularBuffer::CHeader.
+const off_t kPositionsOffset = 32;
+const off_t kPositionsSize = 24;
+
+std::string JournalPath(const std::string& name) {
+    std::string path = testing::TempDir() + "journal_" + name + "_" + std::to_string(getpid());
+    unlink(path.c_str());
+
+    return path;
+}
+
+// Overwrites the copy of the positions with the larger writeptr, as a crash in the middle of writing it would.
+void TearNewestPositions(const std::string& path) {
+    int fd = open(path.c_str(), O_RDWR);
+    uint64_t write[2];
+    pread(fd, &write[0], sizeof(uint64_t), kPositionsOffset + sizeof(uint64_t));
+    pread(fd, &write[1], sizeof(uint64_t), kPositionsOffset + kPositionsSize + sizeof(uint64_t));
+    uint64_t garbage = 12345;
+    pwrite(fd, &garbage, sizeof(garbage), kPositionsOffset + (write[1] > write[0] ? kPositionsSize : 0));
+    close(fd);
+}
+
+}
+
+TEST(PersistentBufferTestSuite, ReopenTest) {
+    std::string path = JournalPath("reopen");
+    {
+        CPersistentCircularBuffer<uint64_t> buf(path, 6);
+        ASSERT_EQ(buf.capacity(), 8);
+        for (uint64_t i = 0; i < 11; ++i)
+            buf.push_back(i);
+        buf.pop_front();
+        ASSERT_EQ(buf.size(), 7);
+    }
+    CPersistentCircularBuffer<uint64_t> buf(path, 8);
+    ASSERT_EQ(buf.size(), 7);
+    for (uint64_t i = 0; i < 7; ++i)
+        ASSERT_EQ(buf[i], i + 4);
+    uint64_t batch[3] = {100, 101, 102};
+    buf.push_back(batch, 3);
+    ASSERT_EQ(buf.size(), 8);
+    ASSERT_EQ(buf.front(), 6);
+    ASSERT_EQ(buf.back(), 102);
+    unlink(path.c_str());
+}
+
+TEST(PersistentBufferTestSuite, CrashTest) {
+    std::string path = JournalPath("crash");
+    pid_t child = fork();
+    ASSERT_NE(child, -1);
+    if (child == 0) {
+        // Leaks the mapping on purpose: _exit() skips the destructor and any msync.
+        auto* buf = new CPersistentCircularBuffer<uint64_t>(path, 16);
+        for (uint64_t i = 0; i < 100; ++i)
+            buf->push_back(i);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    CPersistentCircularBuffer<uint64_t> buf(path, 16);
+    ASSERT_EQ(buf.size(), 16);
+    for (uint64_t i = 0; i < 16; ++i)
+        ASSERT_EQ(buf[i], 84 + i);
+    unlink(path.c_str());
+}
+
+TEST(PersistentBufferTestSuite, TornPositionsTest) {
+    std::string path = JournalPath("torn");
+    {
+        CPersistentCircularBuffer<uint64_t> buf(path, 4);
+        for (uint64_t i = 0; i < 6; ++i)
+            buf.push_back(i);
+    }
+    TearNewestPositions(path);
+    {
+        CPersistentCircularBuffer<uint64_t> buf(path, 4);
+        // The overwriting push of 5 first dropped 1, so the older copy holds 2, 3, 4.
+        ASSERT_EQ(buf.size(), 3);
+        ASSERT_EQ(buf.front(), 2);
+        ASSERT_EQ(buf.back(), 4);
+        buf.push_back(7);
+        buf.push_back(8);
+        ASSERT_EQ(buf.front(), 3);
+    }
+    CPersistentCircularBuffer<uint64_t> buf(path, 4);
+    ASSERT_EQ(buf.size(), 4);
+    ASSERT_EQ(buf.front(), 3);
+    ASSERT_EQ(buf.back(), 8);
+    unlink(path.c_str());
+}
+
+TEST(PersistentBufferTestSuite, MismatchTest) {
+    std::string path = JournalPath("mismatch");
+    {
+        CPersistentCircularBuffer<uint64_t> buf(path, 1024);
+        buf.push_back(1);
+    }
+    ASSERT_THROW((CPersistentCircularBuffer<uint64_t>(path, 2048)), std::runtime_error);
+    ASSERT_THROW((CPersistentCircularBuffer<uint32_t>(path, 2048)), std::runtime_error);
+    ASSERT_EQ((CPersistentCircularBuffer<uint64_t>(path, 1024).size()), 1);
+    {
+        int fd = open(path.c_str(), O_RDWR);
+        uint64_t garbage = 99;
+        pwrite(fd, &garbage, sizeof(garbage), kPositionsOffset);
+        pwrite(fd, &garbage, sizeof(garbage), kPositionsOffset + kPositionsSize);
+        close(fd);
+    }
+    ASSERT_THROW((CPersistentCircularBuffer<uint64_t>(path, 1024)), std::runtime_error);
+    ASSERT_THROW((CPersistentCircularBuffer<uint64_t>("/nonexistent/journal", 16)), std::system_error);
+    unlink(path.c_str());
+}
+
+TEST(PersistentBufferTestSuite, DurabilityTest) {
+    for (EDurability durability : {EDurability::kNone, EDurability::kPeriodic, EDurability::kPerBatch}) {
+        std::string path = JournalPath("durability");
+        CJournalOptions options;
+        options.durability = durability;
+        options.syncInterval = std::chrono::milliseconds(0);
+        {
+            CPersistentCircularBuffer<uint32_t> buf(path, 1000, options);
+            ASSERT_EQ(buf.capacity(), 1024);
+            uint32_t batch[300];
+            for (uint32_t i = 0; i < 300; ++i)
+                batch[i] = i;
+            for (int round = 0; round < 5; ++round)
+                buf.push_back(batch, 300);
+            buf.pop_front(24);
+            buf.sync();
+        }
+        CPersistentCircularBuffer<uint32_t> buf(path, 1024, options);
+        ASSERT_EQ(buf.size(), 1000);
+        for (uint32_t i = 0; i < 1000; ++i)
+            ASSERT_EQ(buf[i], (i + 500) % 300);
+        buf.clear();
+        ASSERT_TRUE(buf.empty());
+        unlink(path.c_str());
+    }
+}
+#endif
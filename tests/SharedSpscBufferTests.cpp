@@ -0,0 +1,86 @@
+#ifdef __linux__
+#include "lib/CCircularBuffer/CSharedSpscCircularBuffer.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+struct CMessage {
+    uint64_t sequence;
+    uint32_t payload[6];
+};
+
+std::string SegmentName(const std::string& name) { return "/CSharedSpsc_" + name + "_" + std::to_string(getpid()); }
+
+}
+
+TEST(SharedSpscBufferTestSuite, TwoMappingsTest) {
+    CSharedSpscCircularBuffer<uint32_t> producer(SegmentName("mappings"), 3);
+    CSharedSpscCircularBuffer<uint32_t> consumer(producer.name());
+    ASSERT_EQ(producer.capacity(), 4);
+    ASSERT_EQ(consumer.capacity(), 4);
+    ASSERT_EQ(consumer.front(), nullptr);
+    for (uint32_t i = 0; i < 4; ++i)
+        ASSERT_TRUE(producer.try_push(i));
+    ASSERT_FALSE(producer.try_push(4));
+    ASSERT_TRUE(consumer.full());
+    // Same element, two different addresses.
+    ASSERT_NE(consumer.front(), nullptr);
+    ASSERT_EQ(*consumer.front(), 0);
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < 10; ++i) {
+        ASSERT_TRUE(consumer.try_pop(value));
+        ASSERT_EQ(value, i);
+        ASSERT_TRUE(producer.try_push(i + 4));
+    }
+    ASSERT_EQ(producer.size(), 4);
+}
+
+TEST(SharedSpscBufferTestSuite, HeaderTest) {
+    std::string name = SegmentName("header");
+    ASSERT_THROW(CSharedSpscCircularBuffer<uint32_t> missing(name), std::system_error);
+    CSharedSpscCircularBuffer<uint32_t> buf(name, 16);
+    ASSERT_THROW(CSharedSpscCircularBuffer<uint32_t> twice(name, 16), std::system_error);
+    ASSERT_THROW(CSharedSpscCircularBuffer<uint64_t> other(name), std::runtime_error);
+    CSharedSpscCircularBuffer<uint32_t> same(name);
+    ASSERT_EQ(same.capacity(), 16);
+}
+
+TEST(SharedSpscBufferTestSuite, ForkTest) {
+    const uint64_t kMessages = 100000;
+    CSharedSpscCircularBuffer<CMessage> consumer(SegmentName("fork"), 64);
+    pid_t child = fork();
+    ASSERT_NE(child, -1);
+    if (child == 0) {
+        CSharedSpscCircularBuffer<CMessage> producer(consumer.name());
+        for (uint64_t i = 0; i < kMessages; ++i) {
+            CMessage message{i, {}};
+            message.payload[5] = static_cast<uint32_t>(i * 3);
+            while (!producer.try_push(message))
+                std::this_thread::yield();
+        }
+        _exit(0);
+    }
+    CMessage message;
+    for (uint64_t i = 0; i < kMessages; ++i) {
+        while (!consumer.try_pop(message))
+            std::this_thread::yield();
+        ASSERT_EQ(message.sequence, i);
+        ASSERT_EQ(message.payload[5], static_cast<uint32_t>(i * 3));
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+    ASSERT_TRUE(consumer.empty());
+}
+#endif
@@ -0,0 +1,166 @@
+#include "lib/CCircularBuffer/CCircularBuffer.h"
+#include "lib/CCircularBuffer/CAlignedAllocator.h"
+#include "lib/CCircularBuffer/CSimdKernels.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+template<typename T>
+bool Matches(T x, ECompare op, T value) {
+    switch (op) {
+        case ECompare::kEqual:
+            return x == value;
+        case ECompare::kNotEqual:
+            return x != value;
+        case ECompare::kLess:
+            return x < value;
+        case ECompare::kLessEqual:
+            return x <= value;
+        case ECompare::kGreater:
+            return x > value;
+        default:
+            return x >= value;
+    }
+}
+
+// Fills wrapped buffers of many sizes and front positions with small values, so that equal
+// elements are common, and checks every kernel at every level this CPU supports against std algorithms.
+template<typename T, typename Allocator = std::allocator<T>>
+void CheckKernels() {
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> dist(0, 60);
+    ESimdLevel detected = DetectSimdLevel();
+    for (ESimdLevel level : {ESimdLevel::kScalar, ESimdLevel::kSse2, ESimdLevel::kAvx2, ESimdLevel::kAvx512}) {
+        if (level > detected)
+            break;
+        ASSERT_EQ(SetSimdLevel(level), level);
+        for (size_t capacity : {1, 7, 64, 333, 4096}) {
+            CCircularBuffer<T, Allocator> buf(capacity);
+            for (size_t i = 0; i < capacity + capacity / 3; ++i)
+                buf.push_back(static_cast<T>(dist(gen)));
+            for (size_t size : {capacity, capacity / 2, size_t(0)}) {
+                while (buf.size() > size)
+                    buf.pop_front();
+                std::vector<T> expected(buf.cbegin(), buf.cend());
+                T sum = std::accumulate(expected.begin(), expected.end(), T(0));
+                if (std::is_floating_point_v<T>)
+                    ASSERT_NEAR(double(SimdSum(buf)), double(sum), 1e-6 * (1 + std::abs(double(sum))));
+                else
+                    ASSERT_EQ(SimdSum(buf), sum);
+                if (!expected.empty()) {
+                    ASSERT_EQ(SimdMin(buf), *std::min_element(expected.begin(), expected.end()));
+                    ASSERT_EQ(SimdMax(buf), *std::max_element(expected.begin(), expected.end()));
+                }
+                for (ECompare op : {ECompare::kEqual, ECompare::kNotEqual, ECompare::kLess, ECompare::kLessEqual,
+                                    ECompare::kGreater, ECompare::kGreaterEqual}) {
+                    for (T value : {T(0), T(30), T(59), T(61)}) {
+                        auto pred = [op, value](T x) { return Matches(x, op, value); };
+                        ASSERT_EQ(SimdCount(buf, op, value), size_t(std::count_if(expected.begin(), expected.end(), pred)));
+                        ASSERT_EQ(SimdFind(buf, op, value),
+                                  size_t(std::find_if(expected.begin(), expected.end(), pred) - expected.begin()));
+                    }
+                }
+            }
+        }
+    }
+    SetSimdLevel(detected);
+}
+
+// Copies values to an address offset bytes past a 64-byte boundary and checks the span kernels
+// at every level, the vector loops must not load from an address that is not aligned to T.
+template<typename T>
+void CheckUnaligned(const std::vector<T>& values, size_t offset) {
+    std::vector<CCacheLine> storage(values.size() * sizeof(T) / sizeof(CCacheLine) + 2);
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(storage.data()) + offset;
+    std::memcpy(bytes, values.data(), values.size() * sizeof(T));
+    const T* data = reinterpret_cast<const T*>(bytes);
+    T sum = std::accumulate(values.begin(), values.end(), T(0));
+    ESimdLevel detected = DetectSimdLevel();
+    for (ESimdLevel level : {ESimdLevel::kScalar, ESimdLevel::kSse2, ESimdLevel::kAvx2, ESimdLevel::kAvx512}) {
+        if (level > detected)
+            break;
+        SetSimdLevel(level);
+        ASSERT_EQ(SimdSum(data, values.size()), sum);
+        ASSERT_EQ((SimdExtreme<T, ECompare::kLess>(data, values.size(), values[0])),
+                  *std::min_element(values.begin(), values.end()));
+        ASSERT_EQ((SimdCount<T, ECompare::kGreater>(data, values.size(), T(50))),
+                  size_t(std::count_if(values.begin(), values.end(), [](T x) { return x > T(50); })));
+        ASSERT_EQ((SimdFind<T, ECompare::kEqual>(data, values.size(), values.back())),
+                  size_t(std::find(values.begin(), values.end(), values.back()) - values.begin()));
+    }
+    SetSimdLevel(detected);
+}
+
+}
+
+TEST(SimdKernelTestSuite, IntegerTest) {
+    CheckKernels<int8_t>();
+    CheckKernels<uint8_t>();
+    CheckKernels<int16_t>();
+    CheckKernels<int32_t>();
+    CheckKernels<uint64_t>();
+}
+
+TEST(SimdKernelTestSuite, FloatingPointTest) {
+    CheckKernels<float>();
+    CheckKernels<double>();
+}
+
+TEST(SimdKernelTestSuite, AlignedStorageTest) {
+    CheckKernels<int32_t, CAlignedAllocator<int32_t>>();
+    CheckKernels<double, CAlignedAllocator<double, 128>>();
+    CCircularBuffer<float, CAlignedAllocator<float>> buf(100);
+    buf.push_back(1.0f);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(buf.array_one().first) % 64, 0);
+}
+
+TEST(SimdKernelTestSuite, IntegerOverflowTest) {
+    // The lanes overflow int32_t many times over, the sum must wrap like unsigned arithmetic.
+    CCircularBuffer<int32_t> buf(1000);
+    uint32_t expected = 0;
+    for (int32_t i = 0; i < 1300; ++i) {
+        int32_t value = i % 2 == 0 ? std::numeric_limits<int32_t>::max() - i : std::numeric_limits<int32_t>::min() + i * 7;
+        buf.push_back(value);
+    }
+    for (int32_t value : buf)
+        expected += static_cast<uint32_t>(value);
+    ESimdLevel detected = DetectSimdLevel();
+    for (ESimdLevel level : {ESimdLevel::kScalar, ESimdLevel::kSse2, ESimdLevel::kAvx2, ESimdLevel::kAvx512}) {
+        if (level > detected)
+            break;
+        SetSimdLevel(level);
+        ASSERT_EQ(SimdSum(buf), static_cast<int32_t>(expected));
+    }
+    SetSimdLevel(detected);
+}
+
+TEST(SimdKernelTestSuite, UnalignedDataTest) {
+    std::vector<double> doubles(1000);
+    std::vector<int32_t> ints(1000);
+    for (size_t i = 0; i < doubles.size(); ++i) {
+        doubles[i] = double(i * 37 % 101);
+        ints[i] = int32_t(i * 53 % 97);
+    }
+    CheckUnaligned(doubles, 4);
+    CheckUnaligned(doubles, 12);
+    CheckUnaligned(ints, 1);
+    CheckUnaligned(ints, 6);
+}
+
+TEST(SimdKernelTestSuite, CountFlushTest) {
+    // More matching bytes than an 8-bit lane can count.
+    std::vector<int8_t> data(100000, 5);
+    ASSERT_EQ((SimdCount<int8_t, ECompare::kEqual>(data.data() + 1, data.size() - 1, 5)), data.size() - 1);
+    ASSERT_EQ((SimdFind<int8_t, ECompare::kGreater>(data.data(), data.size(), 5)), data.size());
+    data[77777] = 6;
+    ASSERT_EQ((SimdFind<int8_t, ECompare::kGreater>(data.data(), data.size(), 5)), 77777);
+}